@@ -0,0 +1,252 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatBatchDose.h>
+
+
+
+/// @brief Initialize the AlicatBatchDose object (Mass flow controller devices only)
+/// @param device handle to the AlicatModbusRTU object
+AlicatBatchDose::AlicatBatchDose(AlicatModbusRTU& device)
+: _device(device)
+{
+  _minPollInterval   = 50;
+  _maxPollInterval   = 2000;
+  _batchSize         = 0.0;
+  _lastTotal         = 0.0;
+  _lastStatus        = 0;
+  _pollCount         = 0;
+  _completionTime    = 0;
+  _completionLatency = 0;
+  _stallTimeout      = 10000;
+  _running           = false;
+  _complete          = false;
+  _stalled           = false;
+}
+
+
+
+/// @brief Set the bounds of the adaptive poll interval
+/// @param minPollInterval poll interval close to the end of the batch (ms)
+/// @param maxPollInterval poll interval far from the end of the batch (ms)
+void AlicatBatchDose::setPollIntervals(unsigned long minPollInterval, unsigned long maxPollInterval) {
+  _minPollInterval = minPollInterval;
+  _maxPollInterval = maxPollInterval < minPollInterval ? minPollInterval : maxPollInterval;
+}
+
+
+
+/// @brief Set how long the total may go without increasing before the batch is abandoned
+/// @param stallTimeout time without progress before the valve is closed (ms, 0 to disable)
+void AlicatBatchDose::setStallTimeout(unsigned long stallTimeout) {
+  _stallTimeout = stallTimeout;
+}
+
+
+
+/// @brief Reset the totalizer, set the batch size and start flowing
+/// @param batchSize amount to dose (totalizer units, > 0)
+/// @param flowSetpoint setpoint to dose at
+/// @return true if the batch was started, false if the arguments or the device type are invalid or a write failed
+bool AlicatBatchDose::begin(float batchSize, float flowSetpoint) {
+  if (batchSize <= 0.0 || !_device.deviceIsMassFlow() || !_device.deviceIsController()) return false;
+
+  uint16_t data[2];
+
+  if (!_device.sendSpecialCommand(SPECIAL_COMMAND_RESET_TOTALIZER_VALUE, 0)) return false;
+
+  AlicatModbusRTU::floatToRegisters(batchSize, data);
+  if (!_device.writeRegisters(REGISTER_BATCH_SIZE, data, 2)) return false;
+
+  AlicatModbusRTU::floatToRegisters(flowSetpoint, data);
+  if (!_device.writeRegisters(REGISTER_SETPOINT, data, 2)) return false;
+
+  _batchSize         = batchSize;
+  _lastTotal         = 0.0;
+  _lastStatus        = 0;
+  _pollCount         = 0;
+  _completionTime    = 0;
+  _completionLatency = 0;
+  _startTime         = millis();
+  _lastPollTime      = _startTime;
+  _lastProgressTime  = _startTime;
+  _nextPollTime      = _startTime + _minPollInterval;
+  _running           = true;
+  _complete          = false;
+  _stalled           = false;
+
+  return true;
+}
+
+
+
+/// @brief Poll the batch progress when the adaptive interval has elapsed (call this from loop())
+/// @return true if the batch completed during this call, false otherwise
+bool AlicatBatchDose::update() {
+  if (!_running) return false;
+
+  unsigned long now = millis();
+
+  if ((long)(now - _nextPollTime) < 0) return false;
+
+  // status and mass total in one read: REGISTER_DEVICE_STATUS up to the last register of the total statistic
+  int      totalAddress;
+  uint16_t response[MAX_BLOCK_READ_REGISTERS];
+
+  _device.getDeviceStatisticRegisterAddress(6, &totalAddress);
+
+  int registerCount = totalAddress + 2 - REGISTER_DEVICE_STATUS;
+
+  if (!_device.readRegisters(REGISTER_DEVICE_STATUS, registerCount, response)) {
+    _nextPollTime = now + _minPollInterval;
+
+    if (_stallTimeout > 0 && now - _lastProgressTime >= _stallTimeout) stall();
+
+    return false;
+  }
+
+  now = millis();
+  _pollCount++;
+
+  float total = AlicatModbusRTU::registersToFloat(&response[totalAddress - REGISTER_DEVICE_STATUS]);
+
+  _lastStatus = response[0];
+
+  if (total >= _batchSize) {
+    // estimate when the batch size was crossed by interpolating between the last two polls
+    unsigned long crossing = now;
+
+    if (total > _lastTotal) {
+      crossing = _lastPollTime + (unsigned long)((now - _lastPollTime) * (_batchSize - _lastTotal) / (total - _lastTotal));
+    }
+
+    _lastTotal         = total;
+    _completionTime    = now - _startTime;
+    _completionLatency = now - crossing;
+    _running           = false;
+    _complete          = true;
+
+    return true;
+  }
+
+  if (total > _lastTotal) {
+    _lastProgressTime = now;
+  } else if (_stallTimeout > 0 && now - _lastProgressTime >= _stallTimeout) {
+    _lastTotal    = total;
+    _lastPollTime = now;
+    stall();
+
+    return false;
+  }
+
+  // poll again after a quarter of the estimated time left, within the configured bounds
+  unsigned long interval = _maxPollInterval;
+
+  if (total > _lastTotal && now > _lastPollTime) {
+    float rate          = (total - _lastTotal) / (float)(now - _lastPollTime);
+    float remainingTime = (_batchSize - total) / rate;
+
+    if (remainingTime / 4.0 < interval) interval = (unsigned long)(remainingTime / 4.0);
+  }
+
+  if (interval < _minPollInterval) interval = _minPollInterval;
+
+  _lastTotal    = total;
+  _lastPollTime = now;
+  _nextPollTime = now + interval;
+
+  return false;
+}
+
+
+
+/// @brief Stop monitoring the batch and close the valve by setting the setpoint to 0
+void AlicatBatchDose::abort() {
+  if (!_running) return;
+
+  _device.setSetpoint(0.0);
+
+  _running = false;
+}
+
+
+
+/// @brief Abandon a batch whose total stopped increasing and close the valve
+void AlicatBatchDose::stall() {
+  abort();
+
+  _stalled = true;
+}
+
+
+
+/// @brief Check if the batch is being monitored
+/// @return true from begin() until the batch completes or is aborted
+bool AlicatBatchDose::isRunning() {
+  return _running;
+}
+
+
+
+/// @brief Check if the last batch completed
+/// @return true if the batch size was reached, false otherwise
+bool AlicatBatchDose::isComplete() {
+  return _complete;
+}
+
+
+
+/// @brief Check if the last batch was abandoned because the total stopped increasing
+/// @return true if the stall timeout expired without progress, false otherwise
+bool AlicatBatchDose::isStalled() {
+  return _stalled;
+}
+
+
+
+/// @brief Get the progress of the batch as of the last poll
+/// @return dosed fraction of the batch (0.0-1.0)
+float AlicatBatchDose::progress() {
+  if (_batchSize <= 0.0) return 0.0;
+
+  return _lastTotal >= _batchSize ? 1.0 : _lastTotal / _batchSize;
+}
+
+
+
+/// @brief Get the mass total as of the last poll
+/// @return mass total (totalizer units)
+float AlicatBatchDose::total() {
+  return _lastTotal;
+}
+
+
+
+/// @brief Get the device status as of the last poll
+/// @return status bits (see STATUS_BIT_* constants)
+uint16_t AlicatBatchDose::status() {
+  return _lastStatus;
+}
+
+
+
+/// @brief Get the duration of the completed batch
+/// @return time from begin() to the poll that detected completion (ms)
+unsigned long AlicatBatchDose::completionTime() {
+  return _completionTime;
+}
+
+
+
+/// @brief Get the completion detection latency
+/// @return time between the estimated crossing of the batch size and its detection (ms)
+unsigned long AlicatBatchDose::completionLatency() {
+  return _completionLatency;
+}
+
+
+
+/// @brief Get the number of progress polls of the current or last batch
+/// @return poll count
+unsigned long AlicatBatchDose::pollCount() {
+  return _pollCount;
+}
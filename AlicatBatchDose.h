@@ -0,0 +1,53 @@
+#ifndef AlicatBatchDose_h
+    #define AlicatBatchDose_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    // Runs a batch dose on a mass flow controller using REGISTER_BATCH_SIZE.
+    // Progress is monitored by reading the status and the mass total in one
+    // transaction. The poll interval adapts to the estimated time left: far
+    // from the end the total is read rarely, close to the end it is read
+    // every minimum interval. When the batch completes, the detection
+    // latency (time between the estimated crossing of the batch size and the
+    // poll that saw it) is reported. If the total does not increase within
+    // the stall timeout, the valve is closed and the batch is abandoned.
+    class AlicatBatchDose {
+        private:
+            AlicatModbusRTU&    _device;
+            float               _batchSize;
+            float               _lastTotal;
+            uint16_t            _lastStatus;
+            unsigned long       _startTime;
+            unsigned long       _lastPollTime;
+            unsigned long       _nextPollTime;
+            unsigned long       _minPollInterval;
+            unsigned long       _maxPollInterval;
+            unsigned long       _completionTime;
+            unsigned long       _completionLatency;
+            unsigned long       _pollCount;
+            unsigned long       _stallTimeout;
+            unsigned long       _lastProgressTime;
+            bool                _running;
+            bool                _complete;
+            bool                _stalled;
+
+            void  stall();
+
+        public:
+                  AlicatBatchDose(AlicatModbusRTU& device);
+            void  setPollIntervals(unsigned long minPollInterval, unsigned long maxPollInterval);
+            void  setStallTimeout(unsigned long stallTimeout);
+            bool  begin(float batchSize, float flowSetpoint);
+            bool  update();
+            void  abort();
+            bool  isRunning();
+            bool  isComplete();
+            bool  isStalled();
+            float progress();
+            float total();
+            uint16_t status();
+            unsigned long completionTime();
+            unsigned long completionLatency();
+            unsigned long pollCount();
+    };
+#endif
@@ -0,0 +1,126 @@
+#include <Arduino.h>
+#include <AlicatBusBudget.h>
+
+
+
+/// @brief Initialize the AlicatBusBudget object, the bucket starts full
+/// @param transactionsPerSecond sustained transaction rate allowed on the bus
+/// @param burst number of transactions that may be started back to back (>= 1), must cover the largest single charge
+AlicatBusBudget::AlicatBusBudget(float transactionsPerSecond, float burst) {
+  _transactionsPerSecond = transactionsPerSecond;
+  _burst                 = burst < 1.0 ? 1.0 : burst;
+  _tokens                = _burst;
+  _lastRefill            = millis();
+  _reservedShare         = 0.0;
+  _userCount             = 0;
+}
+
+
+
+/// @brief Change the sustained transaction rate
+/// @param transactionsPerSecond sustained transaction rate allowed on the bus
+void AlicatBusBudget::setRate(float transactionsPerSecond) {
+  refill();
+
+  _transactionsPerSecond = transactionsPerSecond;
+}
+
+
+
+/// @brief Register a user of the bus with a reserved share of the rate
+/// @param share fraction of the rate reserved for this user (0-1, 0 for the shared pool only)
+/// @param charge largest number of transactions the user takes at once
+/// @return user id for tryAcquire(), -1 if the user table is full, the shares would exceed 1 or the charge exceeds the burst
+int AlicatBusBudget::addUser(float share, int charge) {
+  if (_userCount >= MAX_BUS_BUDGET_USERS || share < 0.0 || charge < 1) return -1;
+  if (_reservedShare + share > 1.0 || charge > _burst) return -1;
+
+  refill();
+
+  float limit = share * _burst;
+
+  _shares[_userCount]        = share;
+  _reservedLimit[_userCount] = limit < charge ? charge : limit;
+  _reserved[_userCount]      = share > 0.0 ? _reservedLimit[_userCount] : 0.0;
+  _reservedShare            += share;
+
+  return _userCount++;
+}
+
+
+
+/// @brief Take tokens from the shared pool for the given number of transactions if they are available
+/// @param transactions number of transactions about to be started (never succeeds above the burst)
+/// @return true if the tokens were taken and the transactions may start, false otherwise
+bool AlicatBusBudget::tryAcquire(int transactions) {
+  refill();
+
+  if (_tokens < transactions) return false;
+
+  _tokens -= transactions;
+
+  return true;
+}
+
+
+
+/// @brief Take tokens for a registered user, from its reserved bucket first and then from the shared pool
+/// @param user user id returned by addUser()
+/// @param transactions number of transactions about to be started
+/// @return true if the tokens were taken and the transactions may start, false otherwise
+bool AlicatBusBudget::tryAcquire(int user, int transactions) {
+  if (user < 0 || user >= _userCount) return tryAcquire(transactions);
+
+  refill();
+
+  if (_reserved[user] + _tokens < transactions) return false;
+
+  float fromReserved = _reserved[user] < transactions ? _reserved[user] : transactions;
+
+  _reserved[user] -= fromReserved;
+  _tokens         -= transactions - fromReserved;
+
+  return true;
+}
+
+
+
+/// @brief Get the number of transactions that could be started right now from the shared pool
+/// @return available tokens
+float AlicatBusBudget::available() {
+  refill();
+
+  return _tokens;
+}
+
+
+
+/// @brief Get the number of transactions a registered user could start right now
+/// @param user user id returned by addUser()
+/// @return available tokens, reserved and shared
+float AlicatBusBudget::available(int user) {
+  if (user < 0 || user >= _userCount) return available();
+
+  refill();
+
+  return _reserved[user] + _tokens;
+}
+
+
+
+void AlicatBusBudget::refill() {
+  unsigned long now     = millis();
+  float         elapsed = (now - _lastRefill) * _transactionsPerSecond / 1000.0;
+
+  _lastRefill = now;
+
+  _tokens += elapsed * (1.0 - _reservedShare);
+
+  if (_tokens > _burst) _tokens = _burst;
+
+  for (int i = 0; i < _userCount; i++) {
+    _reserved[i] += elapsed * _shares[i];
+
+    if (_reserved[i] > _reservedLimit[i]) _reserved[i] = _reservedLimit[i];
+  }
+}
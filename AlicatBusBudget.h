@@ -0,0 +1,37 @@
+#ifndef AlicatBusBudget_h
+    #define AlicatBusBudget_h
+    #include <Arduino.h>
+
+    #define MAX_BUS_BUDGET_USERS                            8
+
+    // Token bucket limiting the number of transactions per second on one bus.
+    // Every user of the bus (poller, setpoint ramps, ...) asks the budget for
+    // a token before it starts a transaction. Users registered with addUser()
+    // get a reserved share of the rate in their own bucket and only fall back
+    // to the shared pool when that runs dry, so a busy user cannot take the
+    // tokens another user needs. The shared pool refills with the unreserved
+    // rest of the rate; anonymous tryAcquire() calls only draw from it.
+    class AlicatBusBudget {
+        private:
+            float               _transactionsPerSecond;
+            float               _burst;
+            float               _tokens;                                // shared pool
+            unsigned long       _lastRefill;
+            float               _shares[MAX_BUS_BUDGET_USERS];
+            float               _reserved[MAX_BUS_BUDGET_USERS];        // tokens in each user's own bucket
+            float               _reservedLimit[MAX_BUS_BUDGET_USERS];
+            float               _reservedShare;                         // sum of all shares
+            int                 _userCount;
+
+            void  refill();
+
+        public:
+                  AlicatBusBudget(float transactionsPerSecond, float burst);
+            void  setRate(float transactionsPerSecond);
+            int   addUser(float share, int charge);
+            bool  tryAcquire(int transactions);
+            bool  tryAcquire(int user, int transactions);
+            float available();
+            float available(int user);
+    };
+#endif
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include <AlicatPoller.h>
+#include <AlicatSnapshotQueue.h>
+#include <AlicatBusGroup.h>
+
+
+
+/// @brief Initialize an empty bus group
+AlicatBusGroup::AlicatBusGroup() {
+  _busCount  = 0;
+  _nextQueue = 0;
+}
+
+
+
+/// @brief Add a bus to the group
+/// @param poller poller of the devices on the bus
+/// @param queue queue the readings of the bus are published to (one queue per bus)
+/// @return bus index, stored in the bus field of the published snapshots, -1 if the group is full
+int AlicatBusGroup::addBus(AlicatPoller& poller, AlicatSnapshotQueue& queue) {
+  if (_busCount >= MAX_BUSES) return -1;
+
+  _pollers[_busCount] = &poller;
+  _queues[_busCount]  = &queue;
+
+  return _busCount++;
+}
+
+
+
+/// @brief Get the number of buses in the group
+/// @return bus count
+int AlicatBusGroup::busCount() {
+  return _busCount;
+}
+
+
+
+/// @brief Run the poller of one bus and publish its reading (call this from the task owning the bus)
+/// @param bus bus index returned by addBus()
+/// @return true if a reading was published, false otherwise
+bool AlicatBusGroup::serviceBus(int bus) {
+  if (bus < 0 || bus >= _busCount) return false;
+
+  // readings a deadband held back stay in the sample buffer only
+  if (!_pollers[bus]->update() || _pollers[bus]->changedChannels() == 0) return false;
+
+  AlicatSampleBuffer& buffer = _pollers[bus]->buffer();
+  AlicatSnapshot      snapshot;
+
+  buffer.getSnapshot(buffer.newestRow(), &snapshot);
+  snapshot.bus = bus;
+
+  return _queues[bus]->push(snapshot);
+}
+
+
+
+/// @brief Service every bus once (single-threaded use, call this from loop())
+/// @return number of readings published
+int AlicatBusGroup::update() {
+  int published = 0;
+
+  for (int bus = 0; bus < _busCount; bus++) {
+    if (serviceBus(bus)) published++;
+  }
+
+  return published;
+}
+
+
+
+/// @brief Take the next reading from the bus queues, visiting the buses round-robin (consumer side)
+/// @param snapshot receives the reading
+/// @return true if a reading was taken, false if all queues are empty
+bool AlicatBusGroup::pop(AlicatSnapshot *snapshot) {
+  for (int i = 0; i < _busCount; i++) {
+    int bus = (_nextQueue + i) % _busCount;
+
+    if (_queues[bus]->pop(snapshot)) {
+      _nextQueue = (bus + 1) % _busCount;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+
+/// @brief Get the number of readings dropped because a consumer fell behind
+/// @return dropped readings over all buses
+unsigned long AlicatBusGroup::dropped() {
+  unsigned long total = 0;
+
+  for (int bus = 0; bus < _busCount; bus++) total += _queues[bus]->dropped();
+
+  return total;
+}
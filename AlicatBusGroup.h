@@ -0,0 +1,31 @@
+#ifndef AlicatBusGroup_h
+    #define AlicatBusGroup_h
+    #include <Arduino.h>
+    #include <AlicatPoller.h>
+    #include <AlicatSnapshotQueue.h>
+
+    #define MAX_BUSES                                       8
+
+    // Runs one AlicatPoller per serial bus and publishes every new reading
+    // through that bus's AlicatSnapshotQueue. Each queue has exactly one
+    // producer (its bus), so serviceBus() can be called for different buses
+    // from different tasks or cores (e.g. one FreeRTOS task per UART on
+    // ESP32). On single-threaded boards update() services all buses in turn.
+    // Consumers drain all queues with pop().
+    class AlicatBusGroup {
+        private:
+            AlicatPoller*       _pollers[MAX_BUSES];
+            AlicatSnapshotQueue* _queues[MAX_BUSES];
+            int                 _busCount;
+            int                 _nextQueue;
+
+        public:
+                 AlicatBusGroup();
+            int  addBus(AlicatPoller& poller, AlicatSnapshotQueue& queue);
+            int  busCount();
+            bool serviceBus(int bus);
+            int  update();
+            bool pop(AlicatSnapshot *snapshot);
+            unsigned long dropped();
+    };
+#endif
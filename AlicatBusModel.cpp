@@ -0,0 +1,101 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatBusModel.h>
+
+
+
+/// @brief Initialize the AlicatBusModel object
+/// @param baudRate baud rate of the bus
+AlicatBusModel::AlicatBusModel(unsigned long baudRate) {
+  _baudRate   = baudRate;
+  _turnaround = BUS_MODEL_DEFAULT_TURNAROUND;
+}
+
+
+
+/// @brief Change the baud rate of the bus
+/// @param baudRate baud rate of the bus
+void AlicatBusModel::setBaudRate(unsigned long baudRate) {
+  _baudRate = baudRate;
+}
+
+
+
+/// @brief Set the time between the end of a request and the start of the response
+/// @param turnaround device turnaround time (us)
+void AlicatBusModel::setTurnaround(unsigned long turnaround) {
+  _turnaround = turnaround;
+}
+
+
+
+/// @brief Get the baud rate of the bus
+/// @return baud rate
+unsigned long AlicatBusModel::baudRate() {
+  return _baudRate;
+}
+
+
+
+/// @brief Get the time one character takes on the wire
+/// @return character time (us)
+unsigned long AlicatBusModel::characterTime() {
+  if (_baudRate == 0) return 0;
+
+  return (MODBUS_RTU_CHARACTER_BITS * 1000000UL + _baudRate - 1) / _baudRate;
+}
+
+
+
+/// @brief Get the silent interval that ends a frame (3.5 characters, fixed above 19200 baud)
+/// @return frame gap (us)
+unsigned long AlicatBusModel::frameGap() {
+  if (_baudRate > 19200) return MODBUS_RTU_FIXED_FRAME_GAP;
+
+  return (7 * characterTime() + 1) / 2;
+}
+
+
+
+/// @brief Get the time a number of bytes takes on the wire
+/// @param byteCount number of bytes
+/// @return transmission time (us)
+unsigned long AlicatBusModel::bytesTime(int byteCount) {
+  if (_baudRate == 0 || byteCount <= 0) return 0;
+
+  return ((unsigned long)byteCount * MODBUS_RTU_CHARACTER_BITS * 1000000UL + _baudRate - 1) / _baudRate;
+}
+
+
+
+/// @brief Get the time of one read holding registers transaction
+/// @param registerCount number of registers read
+/// @return transaction time including the gap before the next request (us)
+unsigned long AlicatBusModel::readTime(int registerCount) {
+  unsigned long gap        = frameGap();
+  unsigned long turnaround = _turnaround > gap ? _turnaround : gap;
+
+  return bytesTime(MODBUS_RTU_READ_REQUEST_BYTES) + turnaround + bytesTime(MODBUS_RTU_READ_RESPONSE_BYTES + 2*registerCount) + gap;
+}
+
+
+
+/// @brief Get the time of one write multiple registers transaction
+/// @param registerCount number of registers written
+/// @return transaction time including the gap before the next request (us)
+unsigned long AlicatBusModel::writeTime(int registerCount) {
+  unsigned long gap        = frameGap();
+  unsigned long turnaround = _turnaround > gap ? _turnaround : gap;
+
+  return bytesTime(MODBUS_RTU_WRITE_REQUEST_BYTES + 2*registerCount) + turnaround + bytesTime(MODBUS_RTU_WRITE_RESPONSE_BYTES) + gap;
+}
+
+
+
+/// @brief Get the time AlicatModbusRTU::pollSample keeps the bus busy for a device
+/// @param device device being polled
+/// @return poll time (us)
+unsigned long AlicatBusModel::pollTime(AlicatModbusRTU& device) {
+  // status and statistics in one block read
+  return readTime(REGISTER_DEVICE_STATISTIC_1_VALUE - REGISTER_DEVICE_STATUS + 2*device.pollStatisticCount());
+}
@@ -0,0 +1,36 @@
+#ifndef AlicatBusModel_h
+    #define AlicatBusModel_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    #define MODBUS_RTU_CHARACTER_BITS                       11      // start, 8 data, parity or second stop bit, stop
+    #define MODBUS_RTU_READ_REQUEST_BYTES                   8
+    #define MODBUS_RTU_READ_RESPONSE_BYTES                  5       // plus 2 per register
+    #define MODBUS_RTU_WRITE_REQUEST_BYTES                  9       // plus 2 per register
+    #define MODBUS_RTU_WRITE_RESPONSE_BYTES                 8
+    #define MODBUS_RTU_FIXED_FRAME_GAP                      1750    // silent interval above 19200 baud (us)
+    #define BUS_MODEL_DEFAULT_TURNAROUND                    2000    // time the device takes to start its response (us)
+
+    // Timing model of one Modbus RTU bus. A transaction takes the request
+    // frame, the device turnaround (at least the 3.5 character gap), the
+    // response frame and the gap before the next request. All times are in
+    // microseconds and are estimates; measure the turnaround of the real
+    // devices (e.g. with the traffic recorder) and set it for tight budgets.
+    class AlicatBusModel {
+        private:
+            unsigned long       _baudRate;
+            unsigned long       _turnaround;
+
+        public:
+                          AlicatBusModel(unsigned long baudRate);
+            void          setBaudRate(unsigned long baudRate);
+            void          setTurnaround(unsigned long turnaround);
+            unsigned long baudRate();
+            unsigned long characterTime();
+            unsigned long frameGap();
+            unsigned long bytesTime(int byteCount);
+            unsigned long readTime(int registerCount);
+            unsigned long writeTime(int registerCount);
+            unsigned long pollTime(AlicatModbusRTU& device);
+    };
+#endif
@@ -0,0 +1,278 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatBusScheduler.h>
+
+#define TRANSACTION_TYPE_READ                           0
+#define TRANSACTION_TYPE_WRITE                          1
+#define TRANSACTION_TYPE_COMMAND                        2
+
+
+
+/// @brief Initialize an empty scheduler
+AlicatBusScheduler::AlicatBusScheduler() {
+  _queued       = 0;
+  _nextSequence = 0;
+  _poller       = NULL;
+
+  resetStatistics();
+}
+
+
+
+/// @brief Attach a poller that runs whenever no transaction is queued
+/// @param poller poller of the devices on this bus, NULL to detach
+void AlicatBusScheduler::setPoller(AlicatPoller* poller) {
+  _poller = poller;
+}
+
+
+
+/// @brief Queue a read of consecutive holding registers
+/// @param device device to read from
+/// @param registerAddress first register (logical register number)
+/// @param registerCount number of registers (1 to MAX_BLOCK_READ_REGISTERS)
+/// @param registerValues receives the values, must stay valid until the transaction completes
+/// @param priority priority class (see BUS_PRIORITY_* constants)
+/// @param state optional, set to one of the TRANSACTION_STATE_* constants as the transaction progresses
+/// @return true if the transaction was queued, false if it is invalid or the queue is full of more urgent work
+bool AlicatBusScheduler::submitRead(AlicatModbusRTU& device, int registerAddress, int registerCount, uint16_t *registerValues, uint8_t priority, uint8_t *state) {
+  if (registerCount < 1 || registerCount > MAX_BLOCK_READ_REGISTERS) return false;
+
+  return submit(device, TRANSACTION_TYPE_READ, priority, registerAddress, registerCount, NULL, registerValues, state);
+}
+
+
+
+/// @brief Queue a write of consecutive holding registers, the values are copied
+/// @param device device to write to
+/// @param registerAddress first register (logical register number)
+/// @param registerValues values to write
+/// @param registerCount number of registers (1 to BUS_SCHEDULER_MAX_WRITE_REGISTERS)
+/// @param priority priority class (see BUS_PRIORITY_* constants)
+/// @param state optional, set to one of the TRANSACTION_STATE_* constants as the transaction progresses
+/// @return true if the transaction was queued, false if it is invalid or the queue is full of more urgent work
+bool AlicatBusScheduler::submitWrite(AlicatModbusRTU& device, int registerAddress, const uint16_t *registerValues, int registerCount, uint8_t priority, uint8_t *state) {
+  if (registerCount < 1 || registerCount > BUS_SCHEDULER_MAX_WRITE_REGISTERS) return false;
+
+  return submit(device, TRANSACTION_TYPE_WRITE, priority, registerAddress, registerCount, registerValues, NULL, state);
+}
+
+
+
+/// @brief Queue a special command, it fails if the device rejects the command (two frames: command write and status read)
+/// @param device device to send the command to
+/// @param command id of the special command (see SPECIAL_COMMAND_* constants)
+/// @param argument argument of the special command
+/// @param priority priority class (see BUS_PRIORITY_* constants)
+/// @param state optional, set to one of the TRANSACTION_STATE_* constants as the transaction progresses
+/// @return true if the transaction was queued, false if the priority is invalid or the queue is full of more urgent work
+bool AlicatBusScheduler::submitCommand(AlicatModbusRTU& device, uint16_t command, uint16_t argument, uint8_t priority, uint8_t *state) {
+  uint16_t data[2] = { command, argument };
+
+  return submit(device, TRANSACTION_TYPE_COMMAND, priority, REGISTER_COMMAND_ID, 2, data, NULL, state);
+}
+
+
+
+/// @brief Queue a setpoint write at control priority (Controller devices only)
+/// @param device device to write to
+/// @param setpoint desired setpoint value
+/// @param state optional, set to one of the TRANSACTION_STATE_* constants as the transaction progresses
+/// @return true if the transaction was queued, false if the device is not a controller or the queue is full of more urgent work
+bool AlicatBusScheduler::submitSetpoint(AlicatModbusRTU& device, float setpoint, uint8_t *state) {
+  uint16_t data[2];
+
+  if (!device.deviceIsController()) return false;
+
+  AlicatModbusRTU::floatToRegisters(setpoint, data);
+
+  return submitWrite(device, REGISTER_SETPOINT, data, 2, BUS_PRIORITY_CONTROL, state);
+}
+
+
+
+/// @brief Queue a command holding the valve closed at emergency priority (Controller devices only)
+/// @param device device to send the command to
+/// @param state optional, set to one of the TRANSACTION_STATE_* constants as the transaction progresses
+/// @return true if the transaction was queued, false if the device is not a controller or the queue is full of emergency commands
+bool AlicatBusScheduler::holdValveClosed(AlicatModbusRTU& device, uint8_t *state) {
+  if (!device.deviceIsController()) return false;
+
+  return submitCommand(device, SPECIAL_COMMAND_VALVE_SETTING, VALVE_SETTING_HOLD_CLOSE, BUS_PRIORITY_EMERGENCY, state);
+}
+
+
+
+/// @brief Queue a command holding the exhaust valve open at emergency priority (Dual valve controller devices only)
+/// @param device device to send the command to
+/// @param state optional, set to one of the TRANSACTION_STATE_* constants as the transaction progresses
+/// @return true if the transaction was queued, false if the device is not a controller or the queue is full of emergency commands
+bool AlicatBusScheduler::exhaustValve(AlicatModbusRTU& device, uint8_t *state) {
+  if (!device.deviceIsController()) return false;
+
+  return submitCommand(device, SPECIAL_COMMAND_VALVE_SETTING, VALVE_SETTING_EXHAUST, BUS_PRIORITY_EMERGENCY, state);
+}
+
+
+
+/// @brief Run the most urgent queued transaction, or a poll if nothing is queued (call this from loop())
+/// @return true if the bus was used, false otherwise
+bool AlicatBusScheduler::service() {
+  if (_queued == 0) return _poller != NULL && _poller->update();
+
+  // oldest transaction of the most urgent class
+  int next = 0;
+
+  for (int i = 1; i < _queued; i++) {
+    if (_queue[i].priority < _queue[next].priority ||
+        (_queue[i].priority == _queue[next].priority && _queue[i].sequence < _queue[next].sequence)) {
+      next = i;
+    }
+  }
+
+  Transaction transaction = _queue[next];
+  bool        ok          = true;
+
+  remove(next);
+
+  switch (transaction.type) {
+    case TRANSACTION_TYPE_READ:
+      ok = transaction.device->readRegisters(transaction.registerAddress, transaction.registerCount, transaction.readValues);
+      break;
+
+    case TRANSACTION_TYPE_WRITE:
+      ok = transaction.device->writeRegisters(transaction.registerAddress, transaction.values, transaction.registerCount);
+      break;
+
+    case TRANSACTION_TYPE_COMMAND:
+      ok = transaction.device->sendSpecialCommand(transaction.values[0], transaction.values[1]);
+      break;
+  }
+
+  unsigned long latency = micros() - transaction.submitTime;
+
+  if (latency > _worstLatency[transaction.priority]) _worstLatency[transaction.priority] = latency;
+
+  _totalLatency[transaction.priority] += latency;
+  _completed[transaction.priority]++;
+
+  if (transaction.state != NULL) *transaction.state = ok ? TRANSACTION_STATE_DONE : TRANSACTION_STATE_FAILED;
+
+  return true;
+}
+
+
+
+/// @brief Get the number of transactions waiting in the queue
+/// @return queued transaction count
+int AlicatBusScheduler::queued() {
+  return _queued;
+}
+
+
+
+/// @brief Get the longest time from submit to completion seen in a priority class
+/// @param priority priority class (see BUS_PRIORITY_* constants)
+/// @return worst-case latency (us)
+unsigned long AlicatBusScheduler::worstLatency(uint8_t priority) {
+  if (priority >= BUS_PRIORITY_CLASSES) return 0;
+
+  return _worstLatency[priority];
+}
+
+
+
+/// @brief Get the mean time from submit to completion in a priority class
+/// @param priority priority class (see BUS_PRIORITY_* constants)
+/// @return average latency (us), 0 if no transaction of the class has completed
+unsigned long AlicatBusScheduler::averageLatency(uint8_t priority) {
+  if (priority >= BUS_PRIORITY_CLASSES || _completed[priority] == 0) return 0;
+
+  return (unsigned long)(_totalLatency[priority] / _completed[priority]);
+}
+
+
+
+/// @brief Get the number of completed transactions in a priority class
+/// @param priority priority class (see BUS_PRIORITY_* constants)
+/// @return completed transaction count
+unsigned long AlicatBusScheduler::completed(uint8_t priority) {
+  if (priority >= BUS_PRIORITY_CLASSES) return 0;
+
+  return _completed[priority];
+}
+
+
+
+/// @brief Get the number of transactions of a priority class evicted by more urgent ones
+/// @param priority priority class (see BUS_PRIORITY_* constants)
+/// @return dropped transaction count
+unsigned long AlicatBusScheduler::dropped(uint8_t priority) {
+  if (priority >= BUS_PRIORITY_CLASSES) return 0;
+
+  return _dropped[priority];
+}
+
+
+
+/// @brief Clear the latency and completion statistics
+void AlicatBusScheduler::resetStatistics() {
+  for (int i = 0; i < BUS_PRIORITY_CLASSES; i++) {
+    _worstLatency[i] = 0;
+    _totalLatency[i] = 0;
+    _completed[i]    = 0;
+    _dropped[i]      = 0;
+  }
+}
+
+
+
+bool AlicatBusScheduler::submit(AlicatModbusRTU& device, uint8_t type, uint8_t priority, int registerAddress, int registerCount, const uint16_t *values, uint16_t *readValues, uint8_t *state) {
+  if (priority >= BUS_PRIORITY_CLASSES) return false;
+
+  // a full queue gives up its newest, least urgent transaction for a more urgent one
+  if (_queued == BUS_SCHEDULER_QUEUE_LENGTH) {
+    int victim = 0;
+
+    for (int i = 1; i < _queued; i++) {
+      if (_queue[i].priority > _queue[victim].priority ||
+          (_queue[i].priority == _queue[victim].priority && _queue[i].sequence > _queue[victim].sequence)) {
+        victim = i;
+      }
+    }
+
+    if (_queue[victim].priority <= priority) return false;
+
+    if (_queue[victim].state != NULL) *_queue[victim].state = TRANSACTION_STATE_DROPPED;
+
+    _dropped[_queue[victim].priority]++;
+    remove(victim);
+  }
+
+  Transaction& transaction = _queue[_queued++];
+
+  transaction.device          = &device;
+  transaction.type            = type;
+  transaction.priority        = priority;
+  transaction.registerAddress = registerAddress;
+  transaction.registerCount   = registerCount;
+  transaction.readValues      = readValues;
+  transaction.state           = state;
+  transaction.submitTime      = micros();
+  transaction.sequence        = _nextSequence++;
+
+  for (int i = 0; values != NULL && i < registerCount; i++) {
+    transaction.values[i] = values[i];
+  }
+
+  if (state != NULL) *state = TRANSACTION_STATE_QUEUED;
+
+  return true;
+}
+
+
+
+void AlicatBusScheduler::remove(int index) {
+  // order in the array does not matter, the sequence number keeps FIFO order within a class
+  _queue[index] = _queue[--_queued];
+}
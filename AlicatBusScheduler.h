@@ -0,0 +1,70 @@
+#ifndef AlicatBusScheduler_h
+    #define AlicatBusScheduler_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+    #include <AlicatPoller.h>
+
+    #define BUS_SCHEDULER_QUEUE_LENGTH                      16
+    #define BUS_SCHEDULER_MAX_WRITE_REGISTERS               4       // enough for a float or a special command
+
+    #define BUS_PRIORITY_EMERGENCY                          0       // valve hold / exhaust commands
+    #define BUS_PRIORITY_CONTROL                            1       // setpoint writes
+    #define BUS_PRIORITY_TELEMETRY                          2       // reads
+    #define BUS_PRIORITY_CLASSES                            3
+
+    #define TRANSACTION_STATE_QUEUED                        0
+    #define TRANSACTION_STATE_DONE                          1
+    #define TRANSACTION_STATE_FAILED                        2
+    #define TRANSACTION_STATE_DROPPED                       3       // evicted from a full queue by a higher priority transaction
+
+    // Priority queue of transactions for one bus. service() starts exactly one
+    // transaction per call, always the oldest one of the most urgent priority
+    // class, so a control write submitted behind a queue of telemetry reads
+    // goes out at the next frame boundary. The poller, if attached, only runs
+    // when nothing is queued. The time from submit to completion is tracked
+    // per class, so the worst-case latency of control writes can be reported.
+    class AlicatBusScheduler {
+        private:
+            struct Transaction {
+                AlicatModbusRTU*    device;
+                uint8_t             type;
+                uint8_t             priority;
+                int                 registerAddress;
+                int                 registerCount;
+                uint16_t            values[BUS_SCHEDULER_MAX_WRITE_REGISTERS];
+                uint16_t*           readValues;
+                uint8_t*            state;
+                unsigned long       submitTime;
+                unsigned long       sequence;
+            };
+
+            Transaction         _queue[BUS_SCHEDULER_QUEUE_LENGTH];
+            int                 _queued;
+            unsigned long       _nextSequence;
+            AlicatPoller*       _poller;
+            unsigned long       _worstLatency[BUS_PRIORITY_CLASSES];
+            uint64_t            _totalLatency[BUS_PRIORITY_CLASSES];     // 32 bits of microseconds overflow after about 71 minutes
+            unsigned long       _completed[BUS_PRIORITY_CLASSES];
+            unsigned long       _dropped[BUS_PRIORITY_CLASSES];
+
+            bool submit(AlicatModbusRTU& device, uint8_t type, uint8_t priority, int registerAddress, int registerCount, const uint16_t *values, uint16_t *readValues, uint8_t *state);
+            void remove(int index);
+
+        public:
+                 AlicatBusScheduler();
+            void setPoller(AlicatPoller* poller);
+            bool submitRead(AlicatModbusRTU& device, int registerAddress, int registerCount, uint16_t *registerValues, uint8_t priority, uint8_t *state = NULL);
+            bool submitWrite(AlicatModbusRTU& device, int registerAddress, const uint16_t *registerValues, int registerCount, uint8_t priority, uint8_t *state = NULL);
+            bool submitCommand(AlicatModbusRTU& device, uint16_t command, uint16_t argument, uint8_t priority, uint8_t *state = NULL);
+            bool submitSetpoint(AlicatModbusRTU& device, float setpoint, uint8_t *state = NULL);
+            bool holdValveClosed(AlicatModbusRTU& device, uint8_t *state = NULL);
+            bool exhaustValve(AlicatModbusRTU& device, uint8_t *state = NULL);
+            bool service();
+            int  queued();
+            unsigned long worstLatency(uint8_t priority);
+            unsigned long averageLatency(uint8_t priority);
+            unsigned long completed(uint8_t priority);
+            unsigned long dropped(uint8_t priority);
+            void resetStatistics();
+    };
+#endif
@@ -0,0 +1,200 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatBusModel.h>
+#include <AlicatCapacityEstimator.h>
+
+
+
+/// @brief Initialize an empty device list
+/// @param model timing model of the planned bus (baud rate, turnaround)
+AlicatCapacityEstimator::AlicatCapacityEstimator(AlicatBusModel& model)
+: _model(model)
+{
+  _deviceCount = 0;
+}
+
+
+
+/// @brief Add a planned device
+/// @param deviceType type of the device (see DEVICE_TYPE_* constants)
+/// @param channels channels to sample, bit mask of (1 << SAMPLE_CHANNEL_*)
+/// @param sampleRate desired samples per second
+/// @return true if the device was added, false if the list is full or the device type does not provide a channel
+bool AlicatCapacityEstimator::addDevice(int deviceType, uint8_t channels, float sampleRate) {
+  if (_deviceCount >= MAX_ESTIMATOR_DEVICES || channels == 0 || sampleRate <= 0.0) return false;
+  if (deviceType < DEVICE_TYPE_MASS_FLOW_CONTROLLER || deviceType > DEVICE_TYPE_GAUGE_PRESSURE_CONTROLLER) return false;
+
+  for (int channel = 0; channel < SAMPLE_CHANNEL_COUNT; channel++) {
+    if (channel == SAMPLE_CHANNEL_STATUS || !(channels & (1 << channel))) continue;
+
+    if (AlicatModbusRTU::channelStatistic(deviceType, channel) == 0) return false;
+  }
+
+  if (channels >> SAMPLE_CHANNEL_COUNT) return false;
+
+  _devices[_deviceCount].deviceType = deviceType;
+  _devices[_deviceCount].channels   = channels;
+  _devices[_deviceCount].sampleRate = sampleRate;
+  _deviceCount++;
+
+  return true;
+}
+
+
+
+/// @brief Remove all devices
+void AlicatCapacityEstimator::clear() {
+  _deviceCount = 0;
+}
+
+
+
+/// @brief Get the number of planned devices
+/// @return device count
+int AlicatCapacityEstimator::deviceCount() {
+  return _deviceCount;
+}
+
+
+
+/// @brief Get the number of transactions one sample of a device takes
+/// @param index device index, in the order the devices were added
+/// @param blockReads true for one block read over all channels, false for one read per channel
+/// @return transaction count
+int AlicatCapacityEstimator::transactionsPerSample(int index, bool blockReads) {
+  if (index < 0 || index >= _deviceCount) return 0;
+
+  if (blockReads) return 1;
+
+  int transactions = 0;
+
+  for (int channel = 0; channel < SAMPLE_CHANNEL_COUNT; channel++) {
+    if (_devices[index].channels & (1 << channel)) transactions++;
+  }
+
+  return transactions;
+}
+
+
+
+/// @brief Get the bus time one sample of a device takes
+/// @param index device index, in the order the devices were added
+/// @param blockReads true for one block read over all channels, false for one read per channel
+/// @return sample time (us)
+unsigned long AlicatCapacityEstimator::sampleTime(int index, bool blockReads) {
+  if (index < 0 || index >= _deviceCount) return 0;
+
+  Device&       device        = _devices[index];
+  unsigned long time          = 0;
+  int           firstRegister = 0;
+  int           lastRegister  = 0;
+
+  for (int channel = 0; channel < SAMPLE_CHANNEL_COUNT; channel++) {
+    if (!(device.channels & (1 << channel))) continue;
+
+    int first = REGISTER_DEVICE_STATUS;
+    int count = 1;
+
+    if (channel != SAMPLE_CHANNEL_STATUS) {
+      first = REGISTER_DEVICE_STATISTIC_1_VALUE + 2*(AlicatModbusRTU::channelStatistic(device.deviceType, channel) - 1);
+      count = 2;
+    }
+
+    time += _model.readTime(count);
+
+    if (firstRegister == 0 || first < firstRegister) firstRegister = first;
+    if (first + count - 1 > lastRegister) lastRegister = first + count - 1;
+  }
+
+  // registers between the wanted ones are read along, the span is at most 12 registers
+  if (blockReads) return _model.readTime(lastRegister - firstRegister + 1);
+
+  return time;
+}
+
+
+
+/// @brief Get the transactions per second of all devices at their sample rates
+/// @param blockReads true for one block read over all channels, false for one read per channel
+/// @return transactions per second
+float AlicatCapacityEstimator::transactionsPerSecond(bool blockReads) {
+  float transactions = 0.0;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    transactions += transactionsPerSample(i, blockReads) * _devices[i].sampleRate;
+  }
+
+  return transactions;
+}
+
+
+
+/// @brief Get the fraction of the bus time all devices take at their sample rates
+/// @param blockReads true for one block read over all channels, false for one read per channel
+/// @return bus utilization (above 1.0 the bus cannot keep up)
+float AlicatCapacityEstimator::utilization(bool blockReads) {
+  float utilization = 0.0;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    utilization += sampleTime(i, blockReads) * _devices[i].sampleRate / 1000000.0;
+  }
+
+  return utilization;
+}
+
+
+
+/// @brief Get the highest sample rate all devices could be sampled at together, ignoring the requested rates
+/// @param blockReads true for one block read over all channels, false for one read per channel
+/// @return samples per second of each device, 0 without devices
+float AlicatCapacityEstimator::maxSampleRate(bool blockReads) {
+  unsigned long cycleTime = 0;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    cycleTime += sampleTime(i, blockReads);
+  }
+
+  if (cycleTime == 0) return 0.0;
+
+  return 1000000.0 / cycleTime;
+}
+
+
+
+/// @brief Print a report of the bus load with and without block reads
+/// @param out where the report is printed (e.g. Serial)
+void AlicatCapacityEstimator::print(Print& out) {
+  out.print("Baud rate: ");
+  out.print(_model.baudRate());
+  out.print(", devices: ");
+  out.println(_deviceCount);
+
+  for (int i = 0; i < _deviceCount; i++) {
+    out.print("  device ");
+    out.print(i);
+    out.print(" (type ");
+    out.print(_devices[i].deviceType);
+    out.print(") at ");
+    out.print(_devices[i].sampleRate, 2);
+    out.print(" Hz: ");
+    out.print(transactionsPerSample(i, false));
+    out.print(" reads, ");
+    out.print(sampleTime(i, false) / 1000.0, 2);
+    out.print(" ms per sample / block read ");
+    out.print(sampleTime(i, true) / 1000.0, 2);
+    out.println(" ms per sample");
+  }
+
+  for (int mode = 0; mode < 2; mode++) {
+    bool blockReads = mode == 1;
+
+    out.print(blockReads ? "Block reads:          " : "One read per channel: ");
+    out.print(transactionsPerSecond(blockReads), 1);
+    out.print(" transactions/s, utilization ");
+    out.print(100.0 * utilization(blockReads), 1);
+    out.print(" %, max sample rate ");
+    out.print(maxSampleRate(blockReads), 2);
+    out.println(" Hz per device");
+  }
+}
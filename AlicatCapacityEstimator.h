@@ -0,0 +1,39 @@
+#ifndef AlicatCapacityEstimator_h
+    #define AlicatCapacityEstimator_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+    #include <AlicatSampleBuffer.h>
+    #include <AlicatBusModel.h>
+
+    #define MAX_ESTIMATOR_DEVICES                           32
+
+    // Offline capacity calculation for a planned bus. Describe each device by
+    // its type, the channels wanted (bit mask of 1 << SAMPLE_CHANNEL_*) and
+    // the sample rate, then compare the bus load of one read per channel
+    // against one block read per sample. No device has to be connected; run
+    // it from a sketch (see examples/BusCapacityEstimator) and read the report.
+    class AlicatCapacityEstimator {
+        private:
+            struct Device {
+                int             deviceType;
+                uint8_t         channels;
+                float           sampleRate;
+            };
+
+            AlicatBusModel&     _model;
+            Device              _devices[MAX_ESTIMATOR_DEVICES];
+            int                 _deviceCount;
+
+        public:
+                          AlicatCapacityEstimator(AlicatBusModel& model);
+            bool          addDevice(int deviceType, uint8_t channels, float sampleRate);
+            void          clear();
+            int           deviceCount();
+            int           transactionsPerSample(int index, bool blockReads);
+            unsigned long sampleTime(int index, bool blockReads);
+            float         transactionsPerSecond(bool blockReads);
+            float         utilization(bool blockReads);
+            float         maxSampleRate(bool blockReads);
+            void          print(Print& out);
+    };
+#endif
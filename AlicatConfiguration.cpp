@@ -0,0 +1,261 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatConfiguration.h>
+
+
+
+// contiguous register spans of the configuration, in register order
+static const int configurationSpans[CONFIGURATION_SPAN_COUNT][2] = {
+  { REGISTER_SINGLE_EXPONENTIAL_FILTER_ALPHA_GAIN, 4 },   // filter alpha gain, STP density
+  { REGISTER_PROPORTIONAL_GAIN,                    10 },  // P, I, D gains, valve offset, power-up setpoint
+  { REGISTER_MASS_FLOW_UNITS,                      2 },   // mass and volumetric flow units
+  { REGISTER_TOTALIZER_SELECT,                     8 },   // totalizer select and units, STP temperature, gas, analog scale factor, STP volumetric flow units
+  { REGISTER_GAS_NUMBER,                           1 }    // gas number
+};
+
+
+
+// first registers of the 32-bit values in the configuration, these are never written half
+static const int wideRegisters[] = {
+  REGISTER_SINGLE_EXPONENTIAL_FILTER_ALPHA_GAIN, REGISTER_STP_DENSITY,
+  REGISTER_PROPORTIONAL_GAIN, REGISTER_INTEGRAL_GAIN, REGISTER_DERIVATIVE_GAIN, REGISTER_VALVE_OFFSET, REGISTER_POWER_UP_SETPOINT,
+  REGISTER_STP_TEMP, REGISTER_ANALOG_SCALE_FACTOR
+};
+
+
+
+/// @brief Initialize an empty configuration
+AlicatConfiguration::AlicatConfiguration() {
+  memset(registers, 0, sizeof(registers));
+
+  deviceType = 0;
+  valid      = false;
+}
+
+
+
+/// @brief Read the configuration of a device, one block read per span
+/// @param device handle to the AlicatModbusRTU object
+/// @return true if every span was read, false otherwise (the snapshot is marked invalid)
+bool AlicatConfiguration::snapshot(AlicatModbusRTU& device) {
+  int index = 0;
+
+  valid = false;
+
+  for (int span = 0; span < CONFIGURATION_SPAN_COUNT; span++) {
+    if (!device.readRegisters(spanAddress(span), spanLength(span), &registers[index])) return false;
+
+    index += spanLength(span);
+  }
+
+  deviceType = device.getDeviceType();
+  valid      = true;
+
+  return true;
+}
+
+
+
+/// @brief Write the whole configuration to a device, one block write per span
+/// @param device handle to the AlicatModbusRTU object
+/// @return true if every span was written, false if the configuration is invalid, was taken from another device type or a write failed (the spans before it are already written)
+bool AlicatConfiguration::restore(AlicatModbusRTU& device) {
+  if (!valid || deviceType != device.getDeviceType()) return false;
+
+  int index = 0;
+
+  for (int span = 0; span < CONFIGURATION_SPAN_COUNT; span++) {
+    if (!device.writeRegisters(spanAddress(span), &registers[index], spanLength(span))) return false;
+
+    index += spanLength(span);
+  }
+
+  return true;
+}
+
+
+
+/// @brief Write only the registers that differ from the configuration currently on the device
+/// @param device handle to the AlicatModbusRTU object
+/// @param maxGap differing registers separated by up to maxGap matching registers are merged into one write (>= 0)
+/// @return number of write transactions issued (0 if the device already matches), -1 if maxGap is negative, the configuration is invalid, of another device type, the device could not be read or a write failed (the writes before it are already applied)
+int AlicatConfiguration::apply(AlicatModbusRTU& device, int maxGap) {
+  if (maxGap < 0 || !valid || deviceType != device.getDeviceType()) return -1;
+
+  AlicatConfiguration current;
+
+  if (!current.snapshot(device)) return -1;
+
+  int writes = 0;
+  int index  = 0;
+
+  for (int span = 0; span < CONFIGURATION_SPAN_COUNT; span++) {
+    int address   = spanAddress(span);
+    int length    = spanLength(span);
+    int runStart  = -1;
+    int runEnd    = -1;
+
+    for (int i = 0; i <= length; i++) {
+      bool differs = false;
+
+      if (i < length) {
+        differs = registers[index + i] != current.registers[index + i];
+
+        // 32-bit values are written as a whole
+        if (!differs && isWideRegister(address + i) && i + 1 < length) {
+          differs = registers[index + i + 1] != current.registers[index + i + 1];
+        }
+
+        if (!differs && i > 0 && isWideRegister(address + i - 1)) {
+          differs = registers[index + i - 1] != current.registers[index + i - 1];
+        }
+      }
+
+      if (differs) {
+        if (runStart < 0) runStart = i;
+
+        runEnd = i;
+      }
+
+      // flush the run at the end of the span or once the gap gets too wide
+      if (runStart >= 0 && (i == length || i - runEnd > maxGap)) {
+        if (!device.writeRegisters(address + runStart, &registers[index + runStart], runEnd - runStart + 1)) return -1;
+
+        writes++;
+
+        runStart = -1;
+      }
+    }
+
+    index += length;
+  }
+
+  return writes;
+}
+
+
+
+/// @brief Serialize the configuration into a compact blob
+/// @param blob output buffer
+/// @param capacity size of the output buffer (bytes, at least CONFIGURATION_BLOB_LENGTH)
+/// @return number of bytes written, 0 if the configuration is invalid or the buffer is too small
+int AlicatConfiguration::serialize(uint8_t *blob, int capacity) {
+  if (!valid || capacity < CONFIGURATION_BLOB_LENGTH) return 0;
+
+  int length = 0;
+
+  blob[length++] = 'A';
+  blob[length++] = 'C';
+  blob[length++] = CONFIGURATION_BLOB_VERSION;
+  blob[length++] = deviceType;
+  blob[length++] = (uint8_t)(CONFIGURATION_REGISTER_COUNT >> 8);
+  blob[length++] = (uint8_t)(CONFIGURATION_REGISTER_COUNT & 0xFF);
+
+  for (int i = 0; i < CONFIGURATION_REGISTER_COUNT; i++) {
+    blob[length++] = (uint8_t)(registers[i] >> 8);
+    blob[length++] = (uint8_t)(registers[i] & 0xFF);
+  }
+
+  uint16_t crc = crc16(blob, length);
+
+  blob[length++] = (uint8_t)(crc >> 8);
+  blob[length++] = (uint8_t)(crc & 0xFF);
+
+  return length;
+}
+
+
+
+/// @brief Load the configuration from a blob made by serialize()
+/// @param blob serialized configuration
+/// @param length length of the blob (bytes)
+/// @return true if the blob was loaded, false if it is malformed, corrupt or of another version (the configuration is unchanged)
+bool AlicatConfiguration::deserialize(const uint8_t *blob, int length) {
+  if (length != CONFIGURATION_BLOB_LENGTH) return false;
+  if (blob[0] != 'A' || blob[1] != 'C' || blob[2] != CONFIGURATION_BLOB_VERSION) return false;
+  if (((blob[4] << 8) | blob[5]) != CONFIGURATION_REGISTER_COUNT) return false;
+
+  uint16_t crc = ((uint16_t)blob[length - 2] << 8) | blob[length - 1];
+
+  if (crc != crc16(blob, length - 2)) return false;
+
+  deviceType = blob[3];
+
+  for (int i = 0; i < CONFIGURATION_REGISTER_COUNT; i++) {
+    registers[i] = ((uint16_t)blob[6 + 2*i] << 8) | blob[7 + 2*i];
+  }
+
+  valid = true;
+
+  return true;
+}
+
+
+
+/// @brief Find a register in the snapshot
+/// @param registerAddress register address (see REGISTER_* constants)
+/// @return index into registers, -1 if the register is not part of the configuration
+int AlicatConfiguration::registerIndex(int registerAddress) {
+  int index = 0;
+
+  for (int span = 0; span < CONFIGURATION_SPAN_COUNT; span++) {
+    if (registerAddress >= spanAddress(span) && registerAddress < spanAddress(span) + spanLength(span)) {
+      return index + registerAddress - spanAddress(span);
+    }
+
+    index += spanLength(span);
+  }
+
+  return -1;
+}
+
+
+
+/// @brief Get the first register address of a configuration span
+/// @param span span index (0 to CONFIGURATION_SPAN_COUNT-1)
+/// @return register address
+int AlicatConfiguration::spanAddress(int span) {
+  return configurationSpans[span][0];
+}
+
+
+
+/// @brief Get the number of registers of a configuration span
+/// @param span span index (0 to CONFIGURATION_SPAN_COUNT-1)
+/// @return register count
+int AlicatConfiguration::spanLength(int span) {
+  return configurationSpans[span][1];
+}
+
+
+
+/// @brief Check if a register is the first register of a 32-bit configuration value
+/// @param registerAddress register address
+/// @return true if the register and the next one hold one 32-bit value, false otherwise
+bool AlicatConfiguration::isWideRegister(int registerAddress) {
+  for (unsigned int i = 0; i < sizeof(wideRegisters) / sizeof(wideRegisters[0]); i++) {
+    if (wideRegisters[i] == registerAddress) return true;
+  }
+
+  return false;
+}
+
+
+
+/// @brief Compute the CRC-16/MODBUS checksum of a buffer
+/// @param data buffer
+/// @param length length of the buffer (bytes)
+/// @return checksum
+uint16_t AlicatConfiguration::crc16(const uint8_t *data, int length) {
+  uint16_t crc = 0xFFFF;
+
+  for (int i = 0; i < length; i++) {
+    crc ^= data[i];
+
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+
+  return crc;
+}
@@ -0,0 +1,39 @@
+#ifndef AlicatConfiguration_h
+    #define AlicatConfiguration_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    #define CONFIGURATION_SPAN_COUNT                        5
+    #define CONFIGURATION_REGISTER_COUNT                    25
+    #define CONFIGURATION_BLOB_VERSION                      1
+    #define CONFIGURATION_BLOB_LENGTH                       (6 + 2*CONFIGURATION_REGISTER_COUNT + 2)  // header, registers, CRC
+
+    // Snapshot of the configuration registers of a device: filter gain and STP
+    // density, PID gains, valve offset and power-up setpoint, flow units,
+    // totalizer, STP temperature, analog scale factor, STP volumetric units
+    // and the gas number. The registers are grouped into a few contiguous
+    // spans so a snapshot or restore is one transaction per span. apply()
+    // only writes the registers that differ from what the device holds.
+    //
+    // Blob layout: 'A' 'C' | version | device type | register count (2) |
+    // registers, big-endian | CRC-16/MODBUS of everything before it, big-endian
+    class AlicatConfiguration {
+        public:
+            uint16_t            registers[CONFIGURATION_REGISTER_COUNT];
+            uint8_t             deviceType;
+            bool                valid;
+
+                 AlicatConfiguration();
+            bool snapshot(AlicatModbusRTU& device);
+            bool restore(AlicatModbusRTU& device);
+            int  apply(AlicatModbusRTU& device, int maxGap);
+            int  serialize(uint8_t *blob, int capacity);
+            bool deserialize(const uint8_t *blob, int length);
+            int  registerIndex(int registerAddress);
+
+            static int spanAddress(int span);
+            static int spanLength(int span);
+            static bool isWideRegister(int registerAddress);
+            static uint16_t crc16(const uint8_t *data, int length);
+    };
+#endif
@@ -0,0 +1,262 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatControlLoop.h>
+
+
+
+/// @brief Initialize the AlicatControlLoop object (Controller devices only)
+/// @param device handle to the AlicatModbusRTU object driven by the loop
+/// @param readSensor callback returning the process value (may itself read from the bus)
+/// @param periodMicros loop period (us, > 0, the loop does not start with a period of 0)
+AlicatControlLoop::AlicatControlLoop(AlicatModbusRTU& device, float (*readSensor)(), unsigned long periodMicros)
+: _device(device)
+{
+  _readSensor = readSensor;
+  _period     = periodMicros;
+  _actuator   = CONTROL_LOOP_ACTUATOR_VALVE_DRIVE;
+  _kp         = 1.0;
+  _ki         = 0.0;
+  _kd         = 0.0;
+  _target     = 0.0;
+  _outputMin  = 0.0;
+  _outputMax  = 100.0;
+  _lastOutput = NAN;
+  _running    = false;
+
+  resetStatistics();
+}
+
+
+
+/// @brief Select how the PID output is written to the controller
+/// @param actuator see CONTROL_LOOP_ACTUATOR_* constants
+void AlicatControlLoop::setActuator(int actuator) {
+  _actuator = actuator;
+}
+
+
+
+/// @brief Set the PID gains (output units per process value unit, per second for ki, times seconds for kd)
+/// @param kp proportional gain
+/// @param ki integral gain
+/// @param kd derivative gain
+void AlicatControlLoop::setGains(float kp, float ki, float kd) {
+  _kp = kp;
+  _ki = ki;
+  _kd = kd;
+}
+
+
+
+/// @brief Clamp the PID output, the integral term is held while the output is clamped
+/// @param outputMin lowest output (default 0.0)
+/// @param outputMax highest output (default 100.0), with the valve drive actuator the limits are narrowed to 0.0-100.0
+/// @return true if the limits were set, false if outputMin is above outputMax (the previous limits are kept)
+bool AlicatControlLoop::setOutputLimits(float outputMin, float outputMax) {
+  if (!(outputMin <= outputMax)) return false;
+
+  _outputMin = outputMin;
+  _outputMax = outputMax;
+
+  return true;
+}
+
+
+
+/// @brief Set the process value the loop drives towards
+/// @param target desired process value
+void AlicatControlLoop::setTarget(float target) {
+  _target = target;
+}
+
+
+
+/// @brief Start the loop, the first cycle runs on the next update()
+/// @return true if the loop was started, false if the period is 0
+bool AlicatControlLoop::start() {
+  if (_period == 0) return false;
+
+  _integral         = 0.0;
+  _lastProcessValue = 0.0;
+  _firstCycle       = true;
+  _nextRun          = micros();
+  _running          = true;
+
+  return true;
+}
+
+
+
+/// @brief Stop the loop, the last output stays on the controller
+void AlicatControlLoop::stop() {
+  _running = false;
+}
+
+
+
+/// @brief Run a cycle if it is due (call this from loop() as often as possible)
+/// @return true if a cycle ran, false otherwise (also when the cycle was skipped because the sensor read NAN or the actuator write failed)
+bool AlicatControlLoop::update() {
+  if (!_running) return false;
+
+  unsigned long now  = micros();
+  long          late = (long)(now - _nextRun);
+
+  if (late < 0) return false;
+
+  // skip the cycles that were missed entirely, the schedule stays on the original grid
+  if ((unsigned long)late >= _period) {
+    unsigned long missed = late / _period;
+
+    _overruns += missed;
+    _nextRun  += missed * _period;
+    late       = (long)(now - _nextRun);
+  }
+
+  unsigned long run = _nextRun;
+
+  _nextRun += _period;
+
+  float processValue = _readSensor();
+
+  if (isnan(processValue)) {
+    _sensorFaults++;
+
+    return false;
+  }
+
+  // derivative on the measurement, a target step does not kick the output;
+  // it spans the cycles skipped since the last good sensor read
+  float dt           = _period / 1000000.0;
+  float error        = _target - processValue;
+  float derivative   = _firstCycle ? 0.0 : -(processValue - _lastProcessValue) / ((run - _lastMeasuredRun) / 1000000.0);
+  float integral     = _integral + error * dt;
+  float output       = _kp * error + _ki * integral + _kd * derivative;
+  float outputMin    = _outputMin;
+  float outputMax    = _outputMax;
+  bool  saturated    = true;
+
+  // the valve drive saturates at 0-100 %, the integral must be held there too
+  if (_actuator != CONTROL_LOOP_ACTUATOR_SETPOINT) {
+    if (outputMin < 0.0)   outputMin = 0.0;
+    if (outputMax > 100.0) outputMax = 100.0;
+    if (outputMin > outputMax) outputMin = outputMax;
+  }
+
+  if (output > outputMax) {
+    output = outputMax;
+  } else if (output < outputMin) {
+    output = outputMin;
+  } else {
+    saturated = false;
+  }
+
+  uint16_t frame[2];
+
+  AlicatModbusRTU::floatToRegisters(output, frame);
+
+  int  outputRegister = _actuator == CONTROL_LOOP_ACTUATOR_SETPOINT ? REGISTER_SETPOINT : REGISTER_DIRECT_VALVE_DRIVE;
+  bool written        = _device.deviceIsController() && _device.writeRegisters(outputRegister, frame, 2);
+
+  if (!written) {
+    _writeFaults++;
+
+    return false;
+  }
+
+  if (!saturated) _integral = integral;
+
+  _lastProcessValue = processValue;
+  _lastMeasuredRun  = run;
+  _lastOutput       = output;
+  _firstCycle       = false;
+
+  unsigned long cycleTime = micros() - now;
+
+  _cycles++;
+  _jitterSum += (unsigned long)late;
+
+  if ((unsigned long)late > _maxJitter)  _maxJitter    = late;
+  if (cycleTime > _maxCycleTime)         _maxCycleTime = cycleTime;
+
+  return true;
+}
+
+
+
+/// @brief Get the output written in the last cycle
+/// @return PID output, NAN before the first cycle
+float AlicatControlLoop::lastOutput() {
+  return _lastOutput;
+}
+
+
+
+/// @brief Get the number of cycles run since the statistics were reset
+/// @return cycle count
+unsigned long AlicatControlLoop::cycles() {
+  return _cycles;
+}
+
+
+
+/// @brief Get the number of cycles skipped because the loop fell a full period behind
+/// @return overrun count
+unsigned long AlicatControlLoop::overruns() {
+  return _overruns;
+}
+
+
+
+/// @brief Get the number of cycles skipped because the sensor read NAN
+/// @return sensor fault count
+unsigned long AlicatControlLoop::sensorFaults() {
+  return _sensorFaults;
+}
+
+
+
+/// @brief Get the number of cycles whose actuator write failed (the PID state was not advanced)
+/// @return write fault count
+unsigned long AlicatControlLoop::writeFaults() {
+  return _writeFaults;
+}
+
+
+
+/// @brief Get the largest delay between the scheduled and the actual start of a cycle
+/// @return maximum start jitter (us)
+unsigned long AlicatControlLoop::maxJitter() {
+  return _maxJitter;
+}
+
+
+
+/// @brief Get the mean delay between the scheduled and the actual start of a cycle
+/// @return mean start jitter (us)
+float AlicatControlLoop::meanJitter() {
+  if (_cycles == 0) return 0.0;
+
+  return (double)_jitterSum / _cycles;
+}
+
+
+
+/// @brief Get the longest cycle (sensor read, PID computation and actuator write)
+/// @return maximum cycle time (us), a cycle time close to the period leaves no bus time for anything else
+unsigned long AlicatControlLoop::maxCycleTime() {
+  return _maxCycleTime;
+}
+
+
+
+/// @brief Reset the timing statistics
+void AlicatControlLoop::resetStatistics() {
+  _cycles       = 0;
+  _overruns     = 0;
+  _sensorFaults = 0;
+  _writeFaults  = 0;
+  _maxJitter    = 0;
+  _maxCycleTime = 0;
+  _jitterSum    = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef AlicatControlLoop_h
+    #define AlicatControlLoop_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    #define CONTROL_LOOP_ACTUATOR_VALVE_DRIVE               0       // write the PID output to REGISTER_DIRECT_VALVE_DRIVE
+    #define CONTROL_LOOP_ACTUATOR_SETPOINT                  1       // write the PID output with setSetpoint
+
+    // Fixed-rate PID loop closed on the host. Each cycle reads an external
+    // sensor through a callback, computes the PID output and writes it to the
+    // controller, in that order, so the sensor read and the actuator write
+    // always share the bus in the same slot. Cycles are scheduled on absolute
+    // times (start + n * period) so timing errors do not accumulate, and the
+    // start jitter of every cycle is recorded. Cycles that are more than a
+    // full period late are skipped and counted as overruns. A cycle whose
+    // sensor reads NAN writes nothing and leaves the PID state untouched, so
+    // the controller holds the last output; a cycle whose actuator write
+    // fails leaves the PID state untouched as well and counts as a write
+    // fault.
+    class AlicatControlLoop {
+        private:
+            AlicatModbusRTU&    _device;
+            float               (*_readSensor)();
+            int                 _actuator;
+            unsigned long       _period;
+            unsigned long       _nextRun;
+            float               _kp;
+            float               _ki;
+            float               _kd;
+            float               _target;
+            float               _outputMin;
+            float               _outputMax;
+            float               _integral;
+            float               _lastProcessValue;
+            unsigned long       _lastMeasuredRun;
+            float               _lastOutput;
+            bool                _running;
+            bool                _firstCycle;
+            unsigned long       _cycles;
+            unsigned long       _overruns;
+            unsigned long       _sensorFaults;
+            unsigned long       _writeFaults;
+            unsigned long       _maxJitter;
+            unsigned long       _maxCycleTime;
+            uint64_t            _jitterSum;     // a float sum of microseconds loses precision on long runs
+
+        public:
+                  AlicatControlLoop(AlicatModbusRTU& device, float (*readSensor)(), unsigned long periodMicros);
+            void  setActuator(int actuator);
+            void  setGains(float kp, float ki, float kd);
+            bool  setOutputLimits(float outputMin, float outputMax);
+            void  setTarget(float target);
+            bool  start();
+            void  stop();
+            bool  update();
+            float lastOutput();
+            unsigned long cycles();
+            unsigned long overruns();
+            unsigned long sensorFaults();
+            unsigned long writeFaults();
+            unsigned long maxJitter();
+            float meanJitter();
+            unsigned long maxCycleTime();
+            void  resetStatistics();
+    };
+#endif
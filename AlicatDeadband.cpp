@@ -0,0 +1,131 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatDeadband.h>
+
+
+
+/// @brief Initialize the filter with zero deadbands (every change is reported)
+AlicatDeadband::AlicatDeadband() {
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT - 1; c++) {
+    _absolute[c] = 0.0;
+    _percent[c]  = 0.0;
+  }
+
+  reset();
+}
+
+
+
+/// @brief Set the deadband of a channel
+/// @param channel channel index (see SAMPLE_CHANNEL_* constants, the status has no deadband)
+/// @param absolute smallest reported change in the units of the channel (>= 0)
+/// @param percent smallest reported change in percent of the last reported value (>= 0)
+void AlicatDeadband::setDeadband(int channel, float absolute, float percent) {
+  if (channel < 0 || channel >= SAMPLE_CHANNEL_COUNT - 1 || absolute < 0.0 || percent < 0.0) return;
+
+  _absolute[channel] = absolute;
+  _percent[channel]  = percent;
+}
+
+
+
+/// @brief Compare one row of a sample buffer with the values last reported for its device
+/// @param device device the reading was taken from
+/// @param buffer sample buffer holding the reading
+/// @param row row of the reading in the buffer
+/// @return changed channels as a bit mask of (1 << SAMPLE_CHANNEL_*), 0 if nothing needs to be published
+uint8_t AlicatDeadband::check(AlicatModbusRTU& device, AlicatSampleBuffer& buffer, int row) {
+  DeviceState *state   = findDevice(&device);
+  uint8_t      changed = 0;
+
+  _checked++;
+
+  // without room to remember the device, every reading is passed on
+  if (state == NULL) {
+    _reported++;
+
+    return DEADBAND_ALL_CHANNELS;
+  }
+
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT - 1; c++) {
+    float value    = buffer.column(c)[row];
+    float previous = state->channels[c];
+    bool  seen     = state->reported & (1 << c);
+
+    if (isnan(value)) {
+      // a channel that disappears is reported once
+      if (seen && !isnan(previous)) changed |= (1 << c);
+    } else if (!seen || isnan(previous)) {
+      changed |= (1 << c);
+    } else {
+      float band = _percent[c] * fabs(previous) / 100.0;
+
+      if (_absolute[c] > band) band = _absolute[c];
+
+      if (fabs(value - previous) > band) changed |= (1 << c);
+    }
+
+    if (changed & (1 << c)) {
+      state->channels[c]  = value;
+      state->reported    |= (1 << c);
+    }
+  }
+
+  if (buffer.status[row] != state->status) {
+    changed       |= (1 << SAMPLE_CHANNEL_STATUS);
+    state->status  = buffer.status[row];
+  }
+
+  if (changed) _reported++;
+
+  return changed;
+}
+
+
+
+/// @brief Forget the reported values, the next reading of every device is reported in full
+void AlicatDeadband::reset() {
+  for (int i = 0; i < MAX_DEADBAND_DEVICES; i++) _devices[i].used = false;
+
+  _checked  = 0;
+  _reported = 0;
+}
+
+
+
+/// @brief Get the number of readings checked
+/// @return checked reading count since the last reset
+unsigned long AlicatDeadband::checkedSamples() {
+  return _checked;
+}
+
+
+
+/// @brief Get the number of readings with at least one changed channel
+/// @return reported reading count since the last reset
+unsigned long AlicatDeadband::reportedSamples() {
+  return _reported;
+}
+
+
+
+AlicatDeadband::DeviceState* AlicatDeadband::findDevice(AlicatModbusRTU* device) {
+  DeviceState *freeState = NULL;
+
+  for (int i = 0; i < MAX_DEADBAND_DEVICES; i++) {
+    if (_devices[i].used && _devices[i].device == device) return &_devices[i];
+    if (!_devices[i].used && freeState == NULL) freeState = &_devices[i];
+  }
+
+  if (freeState != NULL) {
+    freeState->used     = true;
+    freeState->device   = device;
+    freeState->reported = 0;
+    freeState->status   = 0;
+
+    for (int c = 0; c < SAMPLE_CHANNEL_COUNT - 1; c++) freeState->channels[c] = NAN;
+  }
+
+  return freeState;
+}
@@ -0,0 +1,44 @@
+#ifndef AlicatDeadband_h
+    #define AlicatDeadband_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+    #include <AlicatSampleBuffer.h>
+
+    #define MAX_DEADBAND_DEVICES                            20
+    #define DEADBAND_ALL_CHANNELS                           ((1 << SAMPLE_CHANNEL_COUNT) - 1)
+
+    // Change-of-value filter for polled readings. A channel counts as changed
+    // when it moved further than its deadband from the value last reported
+    // for that device; the deadband is the larger of an absolute band and a
+    // percentage of the last reported value. Unreported movements accumulate,
+    // so a slow drift is reported once it crosses the band. Status changes
+    // and channels appearing or disappearing (NAN) are always reported.
+    // Devices are told apart by their AlicatModbusRTU object, so the same
+    // Modbus ID on two buses can share one filter.
+    class AlicatDeadband {
+        private:
+            struct DeviceState {
+                AlicatModbusRTU* device;
+                bool            used;
+                uint8_t         reported;               // bit c is set once channel c has been reported
+                float           channels[SAMPLE_CHANNEL_COUNT - 1];
+                uint16_t        status;
+            };
+
+            DeviceState         _devices[MAX_DEADBAND_DEVICES];
+            float               _absolute[SAMPLE_CHANNEL_COUNT - 1];
+            float               _percent[SAMPLE_CHANNEL_COUNT - 1];
+            unsigned long       _checked;
+            unsigned long       _reported;
+
+            DeviceState* findDevice(AlicatModbusRTU* device);
+
+        public:
+                    AlicatDeadband();
+            void    setDeadband(int channel, float absolute, float percent);
+            uint8_t check(AlicatModbusRTU& device, AlicatSampleBuffer& buffer, int row);
+            void    reset();
+            unsigned long checkedSamples();
+            unsigned long reportedSamples();
+    };
+#endif
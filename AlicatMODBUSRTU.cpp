@@ -7,6 +7,9 @@
 
 #include <Arduino.h>
 #include <ModbusInterface.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatTrafficRecorder.h>
+#include <AlicatTrafficReplay.h>
 #include <AlicatModbusRTU.h>
 
 
@@ -21,6 +24,8 @@ AlicatModbusRTU::AlicatModbusRTU(int modbusID, int deviceType, ModbusInterface&
 : _deviceType(deviceType), _modbus(modbus), _serial(serial)
 {
   _verbose = verbose;
+  _recorder = NULL;
+  _replay   = NULL;
 
   if (deviceType != DEVICE_TYPE_MASS_FLOW_CONTROLLER &&
       deviceType != DEVICE_TYPE_LIQUID_CONTROLLER &&
@@ -56,6 +61,14 @@ void AlicatModbusRTU::setRegisterOffset(int registerOffset) {
 
 
 
+/// @brief Get the register offset of the Alicat device (All devices)
+/// @return offset added to each register address before read or write
+int AlicatModbusRTU::getRegisterOffset() {
+  return _registerOffset;
+}
+
+
+
 /// @brief Set the verbose flag of the Alicat device (All devices)
 /// @param verbose 
 void AlicatModbusRTU::setVerbose(bool verbose) {
@@ -78,6 +91,38 @@ void AlicatModbusRTU::setModbusID(int modbusID) {
 
 
 
+/// @brief Get the Modbus ID of the Alicat device (All devices)
+/// @return Modbus ID of the Alicat device (0-247)
+int AlicatModbusRTU::getModbusID() {
+  return _modbusID;
+}
+
+
+
+/// @brief Get the device type of the Alicat device (All devices)
+/// @return device type (see DEVICE_TYPE_* constants)
+int AlicatModbusRTU::getDeviceType() {
+  return _deviceType;
+}
+
+
+
+/// @brief Record every transaction of this device (All devices)
+/// @param recorder handle to the AlicatTrafficRecorder object, NULL to stop recording
+void AlicatModbusRTU::setTrafficRecorder(AlicatTrafficRecorder* recorder) {
+  _recorder = recorder;
+}
+
+
+
+/// @brief Answer the transactions of this device from a recording instead of the bus (All devices)
+/// @param replay handle to the AlicatTrafficReplay object, NULL to go back to the bus
+void AlicatModbusRTU::setTrafficReplay(AlicatTrafficReplay* replay) {
+  _replay = replay;
+}
+
+
+
 /// @brief Perform the register offset calculation
 /// @param address desired register address
 /// @return offset register address
@@ -115,20 +160,97 @@ void AlicatModbusRTU::getDeviceStatisticRegisterAddress(int statisticIndex, int
  * READ AND WRITE REGISTER FUNCTIONS
 */
 
-/// @brief Read a single register from the Alicat device (All devices)
-/// @param registerAddress desired register address
-/// @param registerValue value of the register read from the Alicat device
-void AlicatModbusRTU::readSingleRegister(int registerAddress, uint16_t *registerValue) {
-  const int dataLength = 1;
-  uint16_t response[dataLength];
+/// @brief Read a block of consecutive registers from the Alicat device in a single transaction (All devices)
+/// @param registerAddress starting register address
+/// @param registerCount number of registers to read (1-MAX_BLOCK_READ_REGISTERS)
+/// @param registerValues buffer receiving the register values, must hold at least registerCount values
+/// @return true if the read succeeded, false otherwise
+bool AlicatModbusRTU::readRegisters(int registerAddress, int registerCount, uint16_t *registerValues) {
+  if (registerCount < 1 || registerCount > MAX_BLOCK_READ_REGISTERS) {
+    if (_verbose) _serial.println("ERROR: function:'readRegisters', argument registerCount is out of bounds");
+
+    return false;
+  }
 
-  if (!_modbus.readHoldingRegisterValues(_modbusID, offsetRegister(registerAddress), dataLength, response)) {
+  bool ok;
+
+  if (_replay != NULL) {
+    ok = _replay->readRegisters(_modbusID, registerAddress, registerCount, registerValues);
+  } else {
+    ok = _modbus.readHoldingRegisterValues(_modbusID, offsetRegister(registerAddress), registerCount, registerValues);
+  }
+
+  if (_recorder != NULL) _recorder->record(_modbusID, MODBUS_FUNCTION_READ_HOLDING_REGISTERS, registerAddress, registerValues, ok ? registerCount : 0, ok);
+
+  if (!ok) {
       _serial.print("ERROR: Failed to read register: ");
       _serial.println(registerAddress);
 
-      return;
+      return false;
+  }
+
+  return true;
+}
+
+
+
+/// @brief Write a block of consecutive registers to the Alicat device in a single transaction (All devices)
+/// @param registerAddress starting register address
+/// @param registerValues values to write to the Alicat device
+/// @param registerCount number of registers to write
+/// @return true if the write succeeded, false otherwise
+bool AlicatModbusRTU::writeRegisters(int registerAddress, uint16_t *registerValues, int registerCount) {
+  bool ok;
+
+  if (_replay != NULL) {
+    ok = _replay->writeRegisters(_modbusID, registerAddress, registerValues, registerCount);
+  } else {
+    ok = _modbus.writeHoldingRegisterValues(_modbusID, offsetRegister(registerAddress), registerValues, registerCount);
   }
 
+  if (_recorder != NULL) _recorder->record(_modbusID, MODBUS_FUNCTION_WRITE_MULTIPLE_REGISTERS, registerAddress, registerValues, registerCount, ok);
+
+  if (!ok) {
+      _serial.print("ERROR: Failed to write register: ");
+      _serial.println(registerAddress);
+
+      return false;
+  }
+
+  return true;
+}
+
+
+
+/// @brief Write a block of consecutive registers to every device on the bus (Modbus ID 0, devices do not reply)
+/// @param registerAddress starting register address
+/// @param registerValues values to write
+/// @param registerCount number of registers to write
+/// @return true if the broadcast was sent, false otherwise (delivery to the devices is not confirmed)
+bool AlicatModbusRTU::broadcastRegisters(int registerAddress, uint16_t *registerValues, int registerCount) {
+  bool ok;
+
+  if (_replay != NULL) {
+    ok = _replay->writeRegisters(0, registerAddress, registerValues, registerCount);
+  } else {
+    ok = _modbus.writeHoldingRegisterValues(0, offsetRegister(registerAddress), registerValues, registerCount);
+  }
+
+  if (_recorder != NULL) _recorder->record(0, MODBUS_FUNCTION_WRITE_MULTIPLE_REGISTERS, registerAddress, registerValues, registerCount, ok);
+
+  return ok;
+}
+
+
+
+/// @brief Read a single register from the Alicat device (All devices)
+/// @param registerAddress desired register address
+/// @param registerValue value of the register read from the Alicat device
+void AlicatModbusRTU::readSingleRegister(int registerAddress, uint16_t *registerValue) {
+  uint16_t response[1];
+
+  if (!readRegisters(registerAddress, 1, response)) return;
+
   *registerValue = response[0];
 }
 
@@ -138,30 +260,22 @@ void AlicatModbusRTU::readSingleRegister(int registerAddress, uint16_t *register
 /// @param registerAddress starting register address
 /// @param floatValue result of the read operation, interpreted as an IEEE 32-bit float
 void AlicatModbusRTU::readRegistersAsFloat(int registerAddress, float *floatValue) {
-  const int dataLength = 2;
-  uint16_t response[dataLength];
+  readRegistersAsFloats(registerAddress, 1, floatValue);
+}
 
-  union {
-    float asFloat;
-    uint16_t asBytes[dataLength];
-  } floatValueUnion;
 
-  if (!_modbus.readHoldingRegisterValues(_modbusID, offsetRegister(registerAddress), dataLength, response)) {
-      _serial.print("ERROR: Failed to read register: ");
-      _serial.println(registerAddress);
-      return;
-  }
 
-  // concatenate the response bytes into a single float using the following format:
-  // All 32-bit values are handled in consecutive Modbus registers in big-
-  // endian format. This means bits 31:16 are in the lower numbered Modbus
-  // register and bits 15:0 are in the higher register. All floating-point values
-  // are IEEE 32-bit floats.
+/// @brief Read consecutive pairs of registers in a single transaction and decode each pair as an IEEE 32-bit float
+/// @param registerAddress starting register address
+/// @param floatCount number of floats to read (1-MAX_BLOCK_READ_REGISTERS/2)
+/// @param floatValues result of the read operation, must hold at least floatCount values
+void AlicatModbusRTU::readRegistersAsFloats(int registerAddress, int floatCount, float *floatValues) {
+  uint16_t response[MAX_BLOCK_READ_REGISTERS];
 
-  floatValueUnion.asBytes[1] = response[0];
-  floatValueUnion.asBytes[0] = response[1];
+  if (!readRegisters(registerAddress, 2*floatCount, response)) return;
 
-  *floatValue = floatValueUnion.asFloat;
+  // decode straight out of the response buffer, no intermediate copies
+  registersToFloats(response, floatCount, floatValues);
 }
 
 
@@ -170,20 +284,11 @@ void AlicatModbusRTU::readRegistersAsFloat(int registerAddress, float *floatValu
 /// @param registerAddress starting register address
 /// @param floatValue desired float value to write to the Alicat device
 void AlicatModbusRTU::writeRegistersAsFloat(int registerAddress, float floatValue) {
-  const int dataLength = 2;
-  
-  union {
-    float asFloat;
-    uint16_t asBytes[dataLength];
-  } floatValueUnion;
-
-  floatValueUnion.asFloat = floatValue;
+  uint16_t data[2];
 
-  uint16_t data[dataLength];
-  data[0] = floatValueUnion.asBytes[1];
-  data[1] = floatValueUnion.asBytes[0];
+  floatToRegisters(floatValue, data);
 
-  _modbus.writeHoldingRegisterValues(_modbusID, offsetRegister(registerAddress), data, dataLength);
+  writeRegisters(registerAddress, data, 2);
 }
 
 
@@ -194,10 +299,173 @@ void AlicatModbusRTU::writeRegistersAsFloat(int registerAddress, float floatValu
 void AlicatModbusRTU::writeSingleRegister(int registerAddress, uint16_t registerValue) {
   uint16_t registerValueArray[1] = { registerValue };
 
-  _modbus.writeHoldingRegisterValues(_modbusID, offsetRegister(registerAddress), registerValueArray, 1);
+  writeRegisters(registerAddress, registerValueArray, 1);
 }
 
 
+
+/**
+ * FLOAT DECODING
+*/
+
+// All 32-bit values are handled in consecutive Modbus registers in big-
+// endian format. This means bits 31:16 are in the lower numbered Modbus
+// register and bits 15:0 are in the higher register. All floating-point values
+// are IEEE 32-bit floats.
+//
+// The words are reassembled with shifts and moved into the float with memcpy,
+// which is independent of the host byte order and avoids union type punning.
+
+/// @brief Decode two consecutive registers (high word first) as an IEEE 32-bit float
+/// @param registers pointer to the first of the two registers
+/// @return decoded float value
+float AlicatModbusRTU::registersToFloat(const uint16_t *registers) {
+  uint32_t bits = ((uint32_t)registers[0] << 16) | registers[1];
+  float floatValue;
+
+  memcpy(&floatValue, &bits, sizeof(floatValue));
+
+  return floatValue;
+}
+
+
+
+/// @brief Decode consecutive register pairs (high word first) as IEEE 32-bit floats
+/// @param registers pointer to the first register, must hold at least 2*floatCount registers
+/// @param floatCount number of floats to decode
+/// @param floatValues decoded float values, must hold at least floatCount values
+void AlicatModbusRTU::registersToFloats(const uint16_t *registers, int floatCount, float *floatValues) {
+  for (int i = 0; i < floatCount; i++) {
+    floatValues[i] = registersToFloat(&registers[2*i]);
+  }
+}
+
+
+
+/// @brief Decode consecutive register pairs as IEEE 32-bit floats into columnar (structure-of-arrays) storage
+/// @param registers pointer to the first register, must hold at least 2*floatCount registers
+/// @param floatCount number of floats to decode
+/// @param columns one output array per float, float i is written to columns[i][row] (NULL columns are skipped)
+/// @param row row of the output arrays to write
+void AlicatModbusRTU::registersToColumns(const uint16_t *registers, int floatCount, float * const *columns, int row) {
+  for (int i = 0; i < floatCount; i++) {
+    if (columns[i] == NULL) continue;
+
+    columns[i][row] = registersToFloat(&registers[2*i]);
+  }
+}
+
+
+
+/// @brief Encode an IEEE 32-bit float into two registers (high word first)
+/// @param floatValue float value to encode
+/// @param registers pointer to the first of the two registers receiving the encoded value
+void AlicatModbusRTU::floatToRegisters(float floatValue, uint16_t *registers) {
+  uint32_t bits;
+
+  memcpy(&bits, &floatValue, sizeof(bits));
+
+  registers[0] = (uint16_t)(bits >> 16);
+  registers[1] = (uint16_t)(bits & 0xFFFF);
+}
+
+
+/// @brief Read a contiguous range of device statistics in a single transaction (All devices)
+/// @param firstStatisticIndex index of the first statistic to read (1-20)
+/// @param statisticCount number of statistics to read (1-20)
+/// @param statistics result of the read operation, must hold at least statisticCount values
+void AlicatModbusRTU::readDeviceStatistics(int firstStatisticIndex, int statisticCount, float *statistics) {
+  if (firstStatisticIndex < 1 || statisticCount < 1 || firstStatisticIndex + statisticCount - 1 > 20) {
+    if (_verbose) _serial.println("ERROR: function:'readDeviceStatistics', requested statistics are out of bounds");
+
+    return;
+  }
+
+  int registerAddress;
+
+  getDeviceStatisticRegisterAddress(firstStatisticIndex, &registerAddress);
+
+  readRegistersAsFloats(registerAddress, statisticCount, statistics);
+}
+
+
+
+/// @brief Get the device statistic that carries a sample channel, the one mapping used by pollSample and the classes built on it
+/// @param deviceType type of the device (see DEVICE_TYPE_* constants)
+/// @param channel sample channel (see SAMPLE_CHANNEL_* constants)
+/// @return statistic index (1 is the first statistic), 0 if the device type does not provide the channel as a statistic
+int AlicatModbusRTU::channelStatistic(int deviceType, int channel) {
+  switch (deviceType) {
+    case DEVICE_TYPE_MASS_FLOW_CONTROLLER:
+      if (channel == SAMPLE_CHANNEL_SETPOINT) return 5;
+      // fall through
+    case DEVICE_TYPE_MASS_FLOW_METER:
+      if (channel == SAMPLE_CHANNEL_MASS_FLOW) return 4;
+      // fall through
+    case DEVICE_TYPE_LIQUID_CONTROLLER:
+      if (channel == SAMPLE_CHANNEL_PRESSURE)        return 1;
+      if (channel == SAMPLE_CHANNEL_TEMPERATURE)     return 2;
+      if (channel == SAMPLE_CHANNEL_VOLUMETRIC_FLOW) return 3;
+      return 0;
+
+    case DEVICE_TYPE_PSID_CONTROLLER:
+    case DEVICE_TYPE_GAUGE_PRESSURE_CONTROLLER:
+      if (channel == SAMPLE_CHANNEL_PRESSURE) return 1;
+      if (channel == SAMPLE_CHANNEL_SETPOINT) return 2;
+      return 0;
+  }
+
+  return 0;
+}
+
+
+
+/// @brief Get the number of device statistics read by pollSample (All devices)
+/// @return statistic count, each statistic is one float (two registers)
+int AlicatModbusRTU::pollStatisticCount() {
+  int statisticCount = 0;
+
+  for (int channel = 0; channel < SAMPLE_CHANNEL_COUNT; channel++) {
+    int statistic = channelStatistic(_deviceType, channel);
+
+    if (statistic > statisticCount) statisticCount = statistic;
+  }
+
+  return statisticCount;
+}
+
+
+
+/// @brief Read the status and the device statistics in one transaction and append them as one row of a sample buffer (All devices)
+/// @param buffer sample buffer the reading is written into
+/// @return true if the sample was written, false if the read failed (nothing is written)
+bool AlicatModbusRTU::pollSample(AlicatSampleBuffer& buffer) {
+  uint16_t response[12];
+  float*   columns[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
+  int      statisticCount = pollStatisticCount();
+
+  // map the device statistics onto the buffer channels, statistics without a channel (totals) are skipped
+  for (int channel = 0; channel < SAMPLE_CHANNEL_COUNT; channel++) {
+    int statistic = channelStatistic(_deviceType, channel);
+
+    if (statistic > 0) columns[statistic - 1] = buffer.column(channel);
+  }
+
+  // the status register sits just ahead of the statistics, so one block read covers both
+  int statisticOffset = REGISTER_DEVICE_STATISTIC_1_VALUE - REGISTER_DEVICE_STATUS;
+
+  if (!readRegisters(REGISTER_DEVICE_STATUS, statisticOffset + 2*statisticCount, response)) return false;
+
+  int row = buffer.append(millis(), _modbusID);
+
+  buffer.status[row] = response[0];
+  registersToColumns(&response[statisticOffset], statisticCount, columns, row);
+
+  return true;
+}
+
+
+
 /**
  * Modbus READING AND STATUS REGISTERS
 */
@@ -239,6 +507,74 @@ void AlicatModbusRTU::getSetpoint(float *setPoint) {
 
 
 
+/// @brief Set the batch size of the Alicat device (Mass flow controller devices only), flow stops once the totalizer reaches it
+/// @param batchSize desired batch size in totalizer units (0 disables batch mode)
+void AlicatModbusRTU::setBatchSize(float batchSize) {
+  if (!deviceIsMassFlow() || !deviceIsController()) {
+    if (_verbose) _serial.println("ERROR: function, 'setBatchSize' is not used for devices of this type");
+
+    return;
+  }
+
+  if (batchSize < 0.0) {
+    if (_verbose) _serial.println("ERROR: function, 'setBatchSize', batchSize must not be negative");
+
+    return;
+  }
+
+  writeRegistersAsFloat(REGISTER_BATCH_SIZE, batchSize);
+}
+
+
+
+/// @brief Get the batch size of the Alicat device (Mass flow controller devices only)
+/// @param batchSize result of the read operation, interpreted as an IEEE 32-bit float
+void AlicatModbusRTU::getBatchSize(float *batchSize) {
+  if (!deviceIsMassFlow() || !deviceIsController()) {
+    if (_verbose) _serial.println("ERROR: function, 'getBatchSize' is not used for devices of this type");
+
+    return;
+  }
+
+  readRegistersAsFloat(REGISTER_BATCH_SIZE, batchSize);
+}
+
+
+
+/// @brief Drive the valve directly, bypassing the PID loop (Controller devices only)
+/// @param valveDrive desired valve drive (0.0-100.0 %)
+void AlicatModbusRTU::setValveDrive(float valveDrive) {
+  if (!deviceIsController()) {
+    if (_verbose) _serial.println("ERROR: function, 'setValveDrive' is not used for devices of this type");
+
+    return;
+  }
+
+  if (valveDrive < 0.0 || valveDrive > 100.0) {
+    if (_verbose) _serial.println("ERROR: function, 'setValveDrive', valveDrive must be between 0 and 100");
+
+    return;
+  }
+
+  writeRegistersAsFloat(REGISTER_DIRECT_VALVE_DRIVE, valveDrive);
+}
+
+
+
+/// @brief Get the direct valve drive of the Alicat device (Controller devices only)
+/// @param valveDrive result of the read operation, interpreted as an IEEE 32-bit float (%)
+void AlicatModbusRTU::getValveDrive(float *valveDrive) {
+  if (!deviceIsController()) {
+    if (_verbose) _serial.println("ERROR: function, 'getValveDrive' is not used for devices of this type");
+
+    return;
+  }
+
+  readRegistersAsFloat(REGISTER_DIRECT_VALVE_DRIVE, valveDrive);
+}
+
+
+
 /// @brief Get the pressure statistic of the Alicat device (All devices)
 /// @param pressure pressure reading, interpreted as an IEEE 32-bit float
 void AlicatModbusRTU::getPressure(float *pressure) {
@@ -366,6 +702,14 @@ void AlicatModbusRTU::getGasNumber(uint16_t *gasIndex) {
 
 
 
+/// @brief Read the raw status word from the Alicat device (All devices)
+/// @param status status bits (see STATUS_BIT_* constants), unchanged if the read fails
+void AlicatModbusRTU::getDeviceStatus(uint16_t *status) {
+  readSingleRegister(REGISTER_DEVICE_STATUS, status);
+}
+
+
+
 /// @brief Read the status flags from the Alicat device (All devices) and store them in the _status struct
 void AlicatModbusRTU::getStatusFlags() {
     uint16_t status;
@@ -559,14 +903,14 @@ void AlicatModbusRTU::setAnalogScaleFactor(float analogScaleFactor) {
 /// @brief Send a special command to the Alicat device (All devices)
 /// @param command id of the special command to send
 /// @param argument argument of the special command to send
-/// @return true if the resulting status code is STATUS_CODE_SUCCESS, false otherwise
+/// @return true if the resulting status code is STATUS_CODE_SUCCESS, false if it is not or the command did not reach the device
 bool AlicatModbusRTU::sendSpecialCommand(uint16_t command, uint16_t argument) {
   uint16_t data[2] = { command, argument };
 
-  _modbus.writeHoldingRegisterValues(_modbusID, offsetRegister(REGISTER_COMMAND_ID), data, 2);
+  if (!writeRegisters(REGISTER_COMMAND_ID, data, 2)) return false;
 
   uint16_t status;
-  readSingleRegister(REGISTER_COMMAND_ARGUMENT, &status);
+  if (!readRegisters(REGISTER_COMMAND_ARGUMENT, 1, &status)) return false;
 
   return handleSpecialCommandStatusCode(status);
 }
@@ -834,6 +1178,55 @@ void AlicatModbusRTU::readIValue() {
 
 
 
+/// @brief Read the P, I and D gains of the PID loop in a single transaction (Controller devices only)
+/// @param p Proportional gain
+/// @param i Integral gain
+/// @param d Derivative gain
+/// @return true if the gains were read, false if the device is not a controller or the read failed (the gains are not changed)
+bool AlicatModbusRTU::getPIDGains(uint32_t *p, uint32_t *i, uint32_t *d) {
+  if (!deviceIsController()) {
+    if (_verbose) _serial.println("ERROR: function, 'getPIDGains' is not used for devices of this type");
+
+    return false;
+  }
+
+  uint16_t response[6];
+
+  if (!readRegisters(REGISTER_PROPORTIONAL_GAIN, 6, response)) return false;
+
+  // 32-bit values, bits 31:16 in the lower numbered register
+  *p = ((uint32_t)response[0] << 16) | response[1];
+  *i = ((uint32_t)response[2] << 16) | response[3];
+  *d = ((uint32_t)response[4] << 16) | response[5];
+
+  return true;
+}
+
+
+
+/// @brief Write the P, I and D gains of the PID loop in a single transaction (Controller devices only)
+/// @param p Proportional gain
+/// @param i Integral gain
+/// @param d Derivative gain
+/// @return true if the gains were written, false if the device is not a controller or the write failed
+bool AlicatModbusRTU::setPIDGains(uint32_t p, uint32_t i, uint32_t d) {
+  if (!deviceIsController()) {
+    if (_verbose) _serial.println("ERROR: function, 'setPIDGains' is not used for devices of this type");
+
+    return false;
+  }
+
+  uint16_t data[6] = {
+    (uint16_t)(p >> 16), (uint16_t)(p & 0xFFFF),
+    (uint16_t)(i >> 16), (uint16_t)(i & 0xFFFF),
+    (uint16_t)(d >> 16), (uint16_t)(d & 0xFFFF)
+  };
+
+  return writeRegisters(REGISTER_PROPORTIONAL_GAIN, data, 6);
+}
+
+
+
 // @todo: define VALVE_CONTROL_OVERRIDE_* constants
 /// @brief Override the device valve control
 /// @param valveControlOverrideArgument valve control override (see VALVE_CONTROL_OVERRIDE_* constants)
@@ -7,6 +7,9 @@
     #define AlicatModbusRTU_h
     #include <Arduino.h>
     #include <ModbusInterface.h>
+    #include <AlicatSampleBuffer.h>
+    #include <AlicatTrafficRecorder.h>
+    #include <AlicatTrafficReplay.h>
 
     #define DEVICE_TYPE_MASS_FLOW_CONTROLLER                0
     #define DEVICE_TYPE_LIQUID_CONTROLLER                   1
@@ -60,15 +63,15 @@
     #define REGISTER_COMMAND_ARGUMENT                       1001    // Access: Read/Write,  Devices: All
     #define REGISTER_SETPOINT                               1010    // Access: Write,       Devices: Controllers (MPL Manual says this is R/W, but it appears to be W only)
     #define REGISTER_SETPOINT_2                             1012
-    #define REGISTER_BATCH_SIZE                             1015
-    #define REGISTER_DIRECT_VALVE_DRIVE                     1018
+    #define REGISTER_BATCH_SIZE                             1015    // Access: Read/Write,  Devices: Mass Flow Controllers
+    #define REGISTER_DIRECT_VALVE_DRIVE                     1018    // Access: Read/Write,  Devices: Controllers
     #define REGISTER_MIXTURE_GAS_1_INDEX                    1050    // Access: Read/Write,  Devices: Mass Flow (All gas mixture indicies, n, can be accessed by adding 2*(n-1) to this starting register value)
     #define REGISTER_MIXTURE_GAS_1_PERCENT                  1051    // Access: Read/Write,  Devices: Mass Flow (All gas mixture percents, n, can be accessed by adding 2*(n-1)+1 to the starting register value of REGISTER_MIXTURE_GAS_1_INDEX)
     #define REGISTER_SINGLE_EXPONENTIAL_FILTER_ALPHA_GAIN   1110
     #define REGISTER_STP_DENSITY                            1112
-    #define REGISTER_PROPORTIONAL_GAIN                      1120
-    #define REGISTER_INTEGRAL_GAIN                          1122
-    #define REGISTER_DERIVATIVE_GAIN                        1124
+    #define REGISTER_PROPORTIONAL_GAIN                      1120    // Access: Read/Write,  Devices: Controllers (32-bit, P, I and D gains are contiguous)
+    #define REGISTER_INTEGRAL_GAIN                          1122    // Access: Read/Write,  Devices: Controllers
+    #define REGISTER_DERIVATIVE_GAIN                        1124    // Access: Read/Write,  Devices: Controllers
     #define REGISTER_VALVE_OFFSET                           1126
     #define REGISTER_POWER_UP_SETPOINT                      1128
     #define REGISTER_MASS_FLOW_UNITS                        1134
@@ -155,6 +158,8 @@
     #define PID_VALUE_D                                     1
     #define PID_VALUE_I                                     2
 
+    #define MAX_BLOCK_READ_REGISTERS                        40      // Largest block read buffered on the stack (covers all 20 device statistics)
+
     class AlicatModbusRTU {
         private:
             HardwareSerial&     _serial;
@@ -163,6 +168,8 @@
             int                 _registerOffset;
             int                 _modbusID;
             int                 _deviceType;
+            AlicatTrafficRecorder* _recorder;
+            AlicatTrafficReplay* _replay;
 
             struct {
                 bool            TEMPERATURE_OVERFLOW;
@@ -185,11 +192,17 @@
         public:
                  AlicatModbusRTU(int modbusID, int deviceType, ModbusInterface& modbus, HardwareSerial& serial, bool verbose);
             void setRegisterOffset(int registerOffset);
+            int  getRegisterOffset();
             void setVerbose(bool verbose);
             void setModbusID(int modbusID);
+            int  getModbusID();
+            int  getDeviceType();
+            void setTrafficRecorder(AlicatTrafficRecorder* recorder);
+            void setTrafficReplay(AlicatTrafficReplay* replay);
             int  offsetRegister(int address);
             void getGasNumber(uint16_t *gasIndex);
             void getStatusFlags();
+            void getDeviceStatus(uint16_t *status);
             void getFlowTemperature(float *flowTemperature);
             void getVolumetricFlow(float *volumetricFlow);
             void getMassFlow(float *massFlow);
@@ -204,12 +217,28 @@
             void createCustomGasMixture(uint16_t gasMixtureIndex);
             void deleteCustomGasMixture(uint16_t gasMixtureIndex);
             void getDeviceStatisticRegisterAddress(int statisticIndex, int *registerAddress);
+            bool readRegisters(int registerAddress, int registerCount, uint16_t *registerValues);
+            bool writeRegisters(int registerAddress, uint16_t *registerValues, int registerCount);
+            bool broadcastRegisters(int registerAddress, uint16_t *registerValues, int registerCount);
             void readSingleRegister(int registerAddress, uint16_t *registerValue);
             void readRegistersAsFloat(int registerAddress, float *floatValue);
+            void readRegistersAsFloats(int registerAddress, int floatCount, float *floatValues);
             void writeRegistersAsFloat(int registerAddress, float floatValue);
             void writeSingleRegister(int registerAddress, uint16_t registerValue);
+            static float registersToFloat(const uint16_t *registers);
+            static void  registersToFloats(const uint16_t *registers, int floatCount, float *floatValues);
+            static void  registersToColumns(const uint16_t *registers, int floatCount, float * const *columns, int row);
+            static void  floatToRegisters(float floatValue, uint16_t *registers);
+            void readDeviceStatistics(int firstStatisticIndex, int statisticCount, float *statistics);
+            static int channelStatistic(int deviceType, int channel);
+            int  pollStatisticCount();
+            bool pollSample(AlicatSampleBuffer& buffer);
             void setSetpoint(float setpoint);
             void getSetpoint(float *setPoint);
+            void setBatchSize(float batchSize);
+            void getBatchSize(float *batchSize);
+            void setValveDrive(float valveDrive);
+            void getValveDrive(float *valveDrive);
             void getPressure(float *pressure);
             void setMixtureGasProperties(int mixtureIndex, uint16_t gasIndex, float gasPercent);
             void getMixtureGasProperties(int mixtureIndex, uint16_t *gasIndex, float *gasPercent);
@@ -242,6 +271,8 @@
             void readPValue();
             void readDValue();
             void readIValue();
+            bool getPIDGains(uint32_t *p, uint32_t *i, uint32_t *d);
+            bool setPIDGains(uint32_t p, uint32_t i, uint32_t d);
             void valveControlOverride(uint16_t valveControlOverrideArgument);
             void changeSetpointSource(uint16_t setpointSourceArgument);
             void setSetPointSourceToDigital();
@@ -0,0 +1,435 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatSnapshotSlot.h>
+#include <AlicatModbusTCPGateway.h>
+
+
+
+/// @brief Initialize a gateway without devices
+AlicatModbusTCPGateway::AlicatModbusTCPGateway() {
+  _deviceCount     = 0;
+  _maxSnapshotAge  = 1000;
+  _timeout         = 100;
+  _cacheHits       = 0;
+  _forwardedReads  = 0;
+  _forwardedWrites = 0;
+  _coalescedReads  = 0;
+}
+
+
+
+/// @brief Map a Modbus TCP unit ID to a device
+/// @param unitID unit ID used by the TCP clients
+/// @param device handle to the AlicatModbusRTU object
+/// @param slot snapshot slot the poller publishes the device readings to, NULL to forward every read
+/// @return true if the device was added, false if the gateway is full or the unit ID is already mapped
+bool AlicatModbusTCPGateway::addDevice(uint8_t unitID, AlicatModbusRTU& device, AlicatSnapshotSlot* slot) {
+  if (_deviceCount >= MAX_GATEWAY_DEVICES || findDevice(unitID) >= 0) return false;
+
+  _unitIDs[_deviceCount] = unitID;
+  _devices[_deviceCount] = &device;
+  _slots[_deviceCount]   = slot;
+  _deviceCount++;
+
+  return true;
+}
+
+
+
+/// @brief Set how old a snapshot may be and still answer a read
+/// @param maxSnapshotAge maximum snapshot age (ms)
+void AlicatModbusTCPGateway::setMaxSnapshotAge(unsigned long maxSnapshotAge) {
+  _maxSnapshotAge = maxSnapshotAge;
+}
+
+
+
+/// @brief Set how long to wait for the rest of a request once its header has arrived
+/// @param timeout request timeout (ms)
+void AlicatModbusTCPGateway::setTimeout(unsigned long timeout) {
+  _timeout = timeout;
+}
+
+
+
+/// @brief Serve one request from a client if a complete header is available (call this from loop())
+/// @param client connection to the Modbus TCP client
+/// @return true if a request was answered or rejected, false otherwise
+bool AlicatModbusTCPGateway::handle(Stream& client) {
+  uint8_t frame[GATEWAY_MAX_FRAME_LENGTH];
+  int     length = receive(client, frame);
+
+  if (length < 0) return true;
+  if (length == 0) return false;
+
+  length = process(frame, length);
+
+  client.write(frame, length);
+
+  return true;
+}
+
+
+
+/// @brief Serve one request from each of several clients, merging reads of the same device into shared RTU transactions
+/// @param clients connections to the Modbus TCP clients
+/// @param clientCount number of clients (up to GATEWAY_MAX_CLIENTS are served per call)
+/// @return number of requests answered or rejected
+int AlicatModbusTCPGateway::handleClients(Stream **clients, int clientCount) {
+  uint8_t frames[GATEWAY_MAX_CLIENTS][GATEWAY_MAX_FRAME_LENGTH];
+  int     lengths[GATEWAY_MAX_CLIENTS];
+  bool    answered[GATEWAY_MAX_CLIENTS];
+  bool    member[GATEWAY_MAX_CLIENTS];
+  int     answeredCount = 0;
+
+  // shared by the snapshot check and the RTU read, the frames dominate the stack use
+  uint16_t registerValues[MAX_BLOCK_READ_REGISTERS];
+
+  if (clientCount > GATEWAY_MAX_CLIENTS) clientCount = GATEWAY_MAX_CLIENTS;
+
+  // collect the pending requests first, so reads arriving together can share a transaction
+  for (int i = 0; i < clientCount; i++) {
+    lengths[i]  = receive(*clients[i], frames[i]);
+    answered[i] = lengths[i] <= 0;
+
+    if (lengths[i] < 0) answeredCount++;
+  }
+
+  for (int i = 0; i < clientCount; i++) {
+    if (answered[i] || !isCoalescableRead(frames[i], lengths[i])) continue;
+
+    int              index  = findDevice(frames[i][6]);
+    AlicatModbusRTU* device = _devices[index];
+    int              first  = readAddress(frames[i], device);
+    int              last   = first + readQuantity(frames[i]) - 1;
+
+    // reads served from a fresh snapshot never reach the bus
+    if (readFromSnapshot(index, first, last - first + 1, registerValues)) continue;
+
+    // attach every later read of the same device that overlaps or touches the
+    // block so far, gaps are never read to bridge two requests
+    for (int j = i; j < clientCount; j++) {
+      member[j] = false;
+
+      if (j != i && (answered[j] || !isCoalescableRead(frames[j], lengths[j]) || frames[j][6] != frames[i][6])) continue;
+
+      int jFirst = readAddress(frames[j], device);
+      int jLast  = jFirst + readQuantity(frames[j]) - 1;
+      int lo     = jFirst < first ? jFirst : first;
+      int hi     = jLast  > last  ? jLast  : last;
+
+      if (jFirst > last + 1 || jLast < first - 1 || hi - lo + 1 > MAX_BLOCK_READ_REGISTERS) continue;
+
+      first     = lo;
+      last      = hi;
+      member[j] = true;
+    }
+
+    bool ok = device->readRegisters(first, last - first + 1, registerValues);
+
+    _forwardedReads++;
+
+    for (int j = i; j < clientCount; j++) {
+      if (!member[j]) continue;
+
+      if (j != i) _coalescedReads++;
+
+      int length;
+
+      if (ok) {
+        length = readResponse(frames[j], &registerValues[readAddress(frames[j], device) - first], readQuantity(frames[j]));
+      } else {
+        length = exception(frames[j], MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED);
+      }
+
+      clients[j]->write(frames[j], length);
+
+      answered[j] = true;
+      answeredCount++;
+    }
+  }
+
+  // everything else (writes, cached reads, malformed requests) is handled one by one
+  for (int i = 0; i < clientCount; i++) {
+    if (answered[i]) continue;
+
+    int length = process(frames[i], lengths[i]);
+
+    clients[i]->write(frames[i], length);
+    answeredCount++;
+  }
+
+  return answeredCount;
+}
+
+
+
+/// @brief Get the number of reads answered from a snapshot
+/// @return cache hit count
+unsigned long AlicatModbusTCPGateway::cacheHits() {
+  return _cacheHits;
+}
+
+
+
+/// @brief Get the number of reads forwarded to the RTU bus
+/// @return forwarded read count
+unsigned long AlicatModbusTCPGateway::forwardedReads() {
+  return _forwardedReads;
+}
+
+
+
+/// @brief Get the number of reads that were answered from another request's RTU transaction
+/// @return coalesced read count
+unsigned long AlicatModbusTCPGateway::coalescedReads() {
+  return _coalescedReads;
+}
+
+
+
+/// @brief Get the number of writes forwarded to the RTU bus
+/// @return forwarded write count
+unsigned long AlicatModbusTCPGateway::forwardedWrites() {
+  return _forwardedWrites;
+}
+
+
+
+/// @brief Read one request from a client
+/// @return request length, 0 if no request has arrived, -1 if a request was rejected (answered with an exception or dropped)
+int AlicatModbusTCPGateway::receive(Stream& client, uint8_t *frame) {
+  if (client.available() < 7) return 0;
+
+  client.setTimeout(_timeout);
+
+  if (client.readBytes(frame, 7) != 7) return 0;
+
+  int pduLength = ((frame[4] << 8) | frame[5]) - 1;
+
+  // not Modbus, or no function code to answer to: drop everything buffered to find the next request
+  if (frame[2] != 0 || frame[3] != 0 || pduLength < 1) {
+    drain(client);
+
+    return -1;
+  }
+
+  // requests larger than we handle are read up to the function code, skipped and rejected
+  bool oversized  = 7 + pduLength > GATEWAY_MAX_FRAME_LENGTH;
+  int  bodyLength = oversized ? 1 : pduLength;
+  int  received   = client.readBytes(&frame[7], bodyLength);
+
+  if (received == bodyLength && !oversized) return 7 + pduLength;
+
+  // a request cut short leaves the stream out of step, whatever follows it is dropped
+  if (received < bodyLength || !skip(client, pduLength - 1)) drain(client);
+
+  if (received > 0) {
+    int length = exception(frame, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+
+    client.write(frame, length);
+  }
+
+  return -1;
+}
+
+
+
+bool AlicatModbusTCPGateway::skip(Stream& client, int count) {
+  uint8_t scratch;
+
+  for (int i = 0; i < count; i++) {
+    if (client.readBytes(&scratch, 1) != 1) return false;
+  }
+
+  return true;
+}
+
+
+
+void AlicatModbusTCPGateway::drain(Stream& client) {
+  while (client.available() > 0) client.read();
+}
+
+
+
+bool AlicatModbusTCPGateway::isCoalescableRead(const uint8_t *frame, int length) {
+  if (length < 12 || frame[7] != MODBUS_FUNCTION_READ_HOLDING_REGISTERS || findDevice(frame[6]) < 0) return false;
+
+  int quantity = readQuantity(frame);
+
+  return quantity >= 1 && quantity <= MAX_BLOCK_READ_REGISTERS;
+}
+
+
+
+int AlicatModbusTCPGateway::readAddress(const uint8_t *frame, AlicatModbusRTU* device) {
+  return ((frame[8] << 8) | frame[9]) - device->getRegisterOffset();
+}
+
+
+
+int AlicatModbusTCPGateway::readQuantity(const uint8_t *frame) {
+  return (frame[10] << 8) | frame[11];
+}
+
+
+
+int AlicatModbusTCPGateway::findDevice(uint8_t unitID) {
+  for (int i = 0; i < _deviceCount; i++) {
+    if (_unitIDs[i] == unitID) return i;
+  }
+
+  return -1;
+}
+
+
+
+/// @brief Build a read response from the device snapshot
+/// @return true if every requested register is carried by a fresh snapshot (the status and the statistic values), false otherwise
+bool AlicatModbusTCPGateway::readFromSnapshot(int index, int registerAddress, int registerCount, uint16_t *registerValues) {
+  AlicatModbusRTU* device = _devices[index];
+  AlicatSnapshot   snapshot;
+
+  if (_slots[index] == NULL || !_slots[index]->read(&snapshot)) return false;
+  if (millis() - snapshot.timestamp > _maxSnapshotAge) return false;
+
+  // statistics carried by the snapshot, in statistic order (see AlicatModbusRTU::channelStatistic)
+  float channels[SAMPLE_CHANNEL_SETPOINT + 1] = { snapshot.pressure, snapshot.temperature, snapshot.volumetricFlow, snapshot.massFlow, snapshot.setpoint };
+  float statistics[SAMPLE_CHANNEL_SETPOINT + 1];
+  int   statisticCount = device->pollStatisticCount();
+
+  for (int channel = SAMPLE_CHANNEL_PRESSURE; channel <= SAMPLE_CHANNEL_SETPOINT; channel++) {
+    int statistic = AlicatModbusRTU::channelStatistic(device->getDeviceType(), channel);
+
+    if (statistic > 0) statistics[statistic - 1] = channels[channel];
+  }
+
+  int lastCached = REGISTER_DEVICE_STATISTIC_1_VALUE + 2*statisticCount - 1;
+
+  int lastAddress = registerAddress + registerCount - 1;
+
+  if (registerAddress < REGISTER_DEVICE_STATUS || lastAddress > lastCached) return false;
+
+  // the registers between the status and the first statistic value are not in the snapshot
+  if (registerAddress < REGISTER_DEVICE_STATISTIC_1_VALUE && lastAddress > REGISTER_DEVICE_STATUS) return false;
+
+  for (int i = 0; i < registerCount; i++) {
+    int address = registerAddress + i;
+
+    if (address == REGISTER_DEVICE_STATUS) {
+      registerValues[i] = snapshot.status;
+    } else {
+      int      offset = address - REGISTER_DEVICE_STATISTIC_1_VALUE;
+      uint16_t words[2];
+
+      AlicatModbusRTU::floatToRegisters(statistics[offset / 2], words);
+      registerValues[i] = words[offset % 2];
+    }
+  }
+
+  return true;
+}
+
+
+
+/// @brief Handle one complete request in place
+/// @return length of the response written over the request
+int AlicatModbusTCPGateway::process(uint8_t *frame, int length) {
+  int index = findDevice(frame[6]);
+
+  if (index < 0) return exception(frame, MODBUS_EXCEPTION_GATEWAY_PATH_UNAVAILABLE);
+
+  AlicatModbusRTU* device       = _devices[index];
+  uint8_t          functionCode = frame[7];
+
+  if (length < 12) return exception(frame, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+
+  int      registerAddress = ((frame[8] << 8) | frame[9]) - device->getRegisterOffset();
+  uint16_t quantity        = (frame[10] << 8) | frame[11];
+  uint16_t registerValues[MAX_BLOCK_READ_REGISTERS];
+
+  switch (functionCode) {
+    case MODBUS_FUNCTION_READ_HOLDING_REGISTERS: {
+      if (quantity < 1 || quantity > MAX_BLOCK_READ_REGISTERS) return exception(frame, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+
+      if (readFromSnapshot(index, registerAddress, quantity, registerValues)) {
+        _cacheHits++;
+      } else {
+        _forwardedReads++;
+
+        if (!device->readRegisters(registerAddress, quantity, registerValues)) return exception(frame, MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED);
+      }
+
+      return readResponse(frame, registerValues, quantity);
+    }
+
+    case MODBUS_FUNCTION_WRITE_SINGLE_REGISTER:
+      // the quantity field holds the value, the request is echoed back
+      registerValues[0] = quantity;
+
+      _forwardedWrites++;
+
+      if (!device->writeRegisters(registerAddress, registerValues, 1)) return exception(frame, MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED);
+
+      length = 12;
+      break;
+
+    case MODBUS_FUNCTION_WRITE_MULTIPLE_REGISTERS:
+      if (quantity < 1 || quantity > MAX_BLOCK_READ_REGISTERS || length < 13 + 2*quantity || frame[12] != 2*quantity) {
+        return exception(frame, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+      }
+
+      for (int i = 0; i < quantity; i++) {
+        registerValues[i] = (frame[13 + 2*i] << 8) | frame[14 + 2*i];
+      }
+
+      _forwardedWrites++;
+
+      if (!device->writeRegisters(registerAddress, registerValues, quantity)) return exception(frame, MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED);
+
+      // the response echoes address and quantity
+      length = 12;
+      break;
+
+    default:
+      return exception(frame, MODBUS_EXCEPTION_ILLEGAL_FUNCTION);
+  }
+
+  frame[4] = (uint8_t)((length - 6) >> 8);
+  frame[5] = (uint8_t)((length - 6) & 0xFF);
+
+  return length;
+}
+
+
+
+/// @brief Turn a read request into its response in place
+/// @return length of the response
+int AlicatModbusTCPGateway::readResponse(uint8_t *frame, const uint16_t *registerValues, int quantity) {
+  int length = 9 + 2*quantity;
+
+  frame[4] = (uint8_t)((length - 6) >> 8);
+  frame[5] = (uint8_t)((length - 6) & 0xFF);
+  frame[8] = 2*quantity;
+
+  for (int i = 0; i < quantity; i++) {
+    frame[9 + 2*i]  = (uint8_t)(registerValues[i] >> 8);
+    frame[10 + 2*i] = (uint8_t)(registerValues[i] & 0xFF);
+  }
+
+  return length;
+}
+
+
+
+/// @brief Turn the request into an exception response in place
+/// @return length of the response
+int AlicatModbusTCPGateway::exception(uint8_t *frame, uint8_t exceptionCode) {
+  frame[4] = 0;
+  frame[5] = 3;
+  frame[7] = frame[7] | 0x80;
+  frame[8] = exceptionCode;
+
+  return 9;
+}
@@ -0,0 +1,72 @@
+#ifndef AlicatModbusTCPGateway_h
+    #define AlicatModbusTCPGateway_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+    #include <AlicatSnapshotSlot.h>
+
+    #define MAX_GATEWAY_DEVICES                             16
+    #define GATEWAY_MAX_CLIENTS                             4       // requests collected per handleClients() call (one frame each on the stack)
+    #define GATEWAY_MAX_FRAME_LENGTH                        (7 + 6 + 2*MAX_BLOCK_READ_REGISTERS)   // MBAP header + largest FC16 request handled
+
+    #define MODBUS_FUNCTION_WRITE_SINGLE_REGISTER           6
+
+    #define MODBUS_EXCEPTION_ILLEGAL_FUNCTION               0x01
+    #define MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE             0x03
+    #define MODBUS_EXCEPTION_GATEWAY_PATH_UNAVAILABLE       0x0A
+    #define MODBUS_EXCEPTION_GATEWAY_TARGET_FAILED          0x0B
+
+    // Serves Modbus TCP requests (FC03, FC06, FC16) for Alicat devices on the
+    // local RTU buses. Unit IDs are mapped to AlicatModbusRTU objects. Reads
+    // that only touch the status register and the statistics carried by an
+    // AlicatSnapshot are answered from the device's snapshot slot while it is
+    // fresh, everything else is forwarded to the bus. Register addresses in
+    // the TCP requests are wire addresses, exactly what the device expects
+    // on RTU. handle() works on any Stream (EthernetClient, WiFiClient, ...).
+    // A request that is not Modbus (protocol ID other than 0), too large or
+    // cut short is rejected with an exception where its function code is
+    // known, and the bytes buffered behind it are dropped so the next request
+    // starts on a frame boundary.
+    // handleClients() first collects one request from each of several
+    // clients, then answers reads of the same device whose ranges overlap or
+    // touch from a single RTU transaction. It keeps GATEWAY_MAX_CLIENTS
+    // frames and one register block on the stack, about 460 bytes with the
+    // defaults: on boards with 2 KB of RAM (e.g. AVR) lower
+    // GATEWAY_MAX_CLIENTS or serve the clients one by one with handle().
+    class AlicatModbusTCPGateway {
+        private:
+            uint8_t             _unitIDs[MAX_GATEWAY_DEVICES];
+            AlicatModbusRTU*    _devices[MAX_GATEWAY_DEVICES];
+            AlicatSnapshotSlot* _slots[MAX_GATEWAY_DEVICES];
+            int                 _deviceCount;
+            unsigned long       _maxSnapshotAge;
+            unsigned long       _timeout;
+            unsigned long       _cacheHits;
+            unsigned long       _forwardedReads;
+            unsigned long       _forwardedWrites;
+            unsigned long       _coalescedReads;
+
+            int  receive(Stream& client, uint8_t *frame);
+            bool skip(Stream& client, int count);
+            void drain(Stream& client);
+            bool isCoalescableRead(const uint8_t *frame, int length);
+            int  readAddress(const uint8_t *frame, AlicatModbusRTU* device);
+            int  readQuantity(const uint8_t *frame);
+            int  findDevice(uint8_t unitID);
+            bool readFromSnapshot(int index, int registerAddress, int registerCount, uint16_t *registerValues);
+            int  process(uint8_t *frame, int length);
+            int  readResponse(uint8_t *frame, const uint16_t *registerValues, int quantity);
+            int  exception(uint8_t *frame, uint8_t exceptionCode);
+
+        public:
+                 AlicatModbusTCPGateway();
+            bool addDevice(uint8_t unitID, AlicatModbusRTU& device, AlicatSnapshotSlot* slot);
+            void setMaxSnapshotAge(unsigned long maxSnapshotAge);
+            void setTimeout(unsigned long timeout);
+            bool handle(Stream& client);
+            int  handleClients(Stream **clients, int clientCount);
+            unsigned long cacheHits();
+            unsigned long forwardedReads();
+            unsigned long forwardedWrites();
+            unsigned long coalescedReads();
+    };
+#endif
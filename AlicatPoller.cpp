@@ -0,0 +1,267 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatBusBudget.h>
+#include <AlicatSnapshotSlot.h>
+#include <AlicatBusModel.h>
+#include <AlicatStatusMonitor.h>
+#include <AlicatDeadband.h>
+#include <AlicatPoller.h>
+
+
+
+/// @brief Initialize the AlicatPoller object
+/// @param buffer sample buffer the readings are written into
+/// @param pollInterval time between two polls of the same device, for devices added without their own interval (ms)
+AlicatPoller::AlicatPoller(AlicatSampleBuffer& buffer, unsigned long pollInterval)
+: _buffer(buffer)
+{
+  _budget          = NULL;
+  _budgetUser      = -1;
+  _slots           = NULL;
+  _model           = NULL;
+  _monitor         = NULL;
+  _deadband        = NULL;
+  _changedChannels = 0;
+  _deviceCount     = 0;
+  _started         = false;
+  _pollInterval    = pollInterval;
+  _deadlineMisses  = 0;
+}
+
+
+
+/// @brief Add a device to the poll list, polled at the poller's interval
+/// @param device handle to the AlicatModbusRTU object
+/// @return true if the device was added, false if the poll list is full
+bool AlicatPoller::addDevice(AlicatModbusRTU& device) {
+  return addDevice(device, 0);
+}
+
+
+
+/// @brief Add a device to the poll list with its own poll interval
+/// @param device handle to the AlicatModbusRTU object
+/// @param pollInterval time between two polls of this device (ms), 0 to follow the poller's interval
+/// @return true if the device was added, false if the poll list is full
+bool AlicatPoller::addDevice(AlicatModbusRTU& device, unsigned long pollInterval) {
+  if (_deviceCount >= MAX_POLLER_DEVICES) return false;
+
+  _devices[_deviceCount]   = &device;
+  _intervals[_deviceCount] = pollInterval;
+  _releases[_deviceCount]  = millis();
+  _deviceCount++;
+
+  return true;
+}
+
+
+
+/// @brief Get the number of devices on the poll list
+/// @return number of devices
+int AlicatPoller::deviceCount() {
+  return _deviceCount;
+}
+
+
+
+/// @brief Get the sample buffer the poller writes into
+/// @return handle to the AlicatSampleBuffer object
+AlicatSampleBuffer& AlicatPoller::buffer() {
+  return _buffer;
+}
+
+
+
+/// @brief Set the time between two polls of the same device
+/// @param pollInterval poll interval (ms) of the devices added without their own interval
+void AlicatPoller::setPollInterval(unsigned long pollInterval) {
+  _pollInterval = pollInterval;
+}
+
+
+
+/// @brief Share a bus budget with the other users of the bus (e.g. setpoint ramps)
+/// @param budget handle to the AlicatBusBudget object, NULL for no limit
+/// @param share fraction of the bus rate reserved for this user (0 for the shared pool only)
+/// @return true if the budget was attached, false if it cannot grant the share (the previous budget is kept)
+bool AlicatPoller::setBusBudget(AlicatBusBudget* budget, float share) {
+  int user = -1;
+
+  if (budget != NULL) {
+    user = budget->addUser(share, 1);
+
+    if (user < 0) return false;
+  }
+
+  _budget     = budget;
+  _budgetUser = user;
+
+  return true;
+}
+
+
+
+/// @brief Publish the latest reading of every device to a snapshot slot
+/// @param slots one slot per device, in the order the devices were added (at least deviceCount() slots), NULL to stop publishing
+void AlicatPoller::setSnapshotSlots(AlicatSnapshotSlot* slots) {
+  _slots = slots;
+}
+
+
+
+/// @brief Use a timing model of the bus for the capacity calculation
+/// @param model handle to the AlicatBusModel object, NULL to remove it
+void AlicatPoller::setBusModel(AlicatBusModel* model) {
+  _model = model;
+}
+
+
+
+/// @brief Pass the status of every poll to a status monitor, so polled devices need no separate status reads
+/// @param monitor handle to the AlicatStatusMonitor object, NULL to stop passing statuses
+void AlicatPoller::setStatusMonitor(AlicatStatusMonitor* monitor) {
+  _monitor = monitor;
+}
+
+
+
+/// @brief Pass on only readings that changed by more than a deadband (see changedChannels()), the buffer and the snapshot slots still receive every poll
+/// @param deadband handle to the AlicatDeadband object, NULL to pass on every reading
+void AlicatPoller::setDeadband(AlicatDeadband* deadband) {
+  _deadband = deadband;
+}
+
+
+
+/// @brief Get the channels of the last poll that are worth publishing
+/// @return bit mask of (1 << SAMPLE_CHANNEL_*), all channels without a deadband, 0 if nothing changed
+uint8_t AlicatPoller::changedChannels() {
+  return _changedChannels;
+}
+
+
+
+/// @brief Get the fraction of the bus time the polls take at the configured intervals (requires a bus model)
+/// @return bus utilization (1.0 is a fully loaded bus), 0 without a bus model, -1 if a device has a poll interval of 0 (polled back to back, no finite load)
+float AlicatPoller::utilization() {
+  if (_model == NULL) return 0.0;
+
+  float utilization = 0.0;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    if (deviceInterval(i) == 0) return -1.0;
+
+    utilization += (float)_model->pollTime(*_devices[i]) / (1000.0 * deviceInterval(i));
+  }
+
+  return utilization;
+}
+
+
+
+/// @brief Check whether every poll can meet its deadline (requires a bus model)
+/// @return true if the schedule is feasible, false if it is not or there is no bus model
+bool AlicatPoller::isFeasible() {
+  if (_model == NULL) return false;
+
+  // a poll cannot be interrupted once started, so the shortest interval must
+  // also absorb the longest poll that may have just begun
+  unsigned long longestPoll      = 0;
+  unsigned long shortestInterval = 0;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    unsigned long pollTime = _model->pollTime(*_devices[i]);
+
+    if (deviceInterval(i) == 0) return false;
+
+    if (pollTime > longestPoll) longestPoll = pollTime;
+    if (shortestInterval == 0 || deviceInterval(i) < shortestInterval) shortestInterval = deviceInterval(i);
+  }
+
+  if (_deviceCount == 0) return true;
+
+  return utilization() + (float)longestPoll / (1000.0 * shortestInterval) <= 1.0;
+}
+
+
+
+/// @brief Get the number of polls that finished after their deadline
+/// @return deadline miss count
+unsigned long AlicatPoller::deadlineMisses() {
+  return _deadlineMisses;
+}
+
+
+
+/// @brief Poll the released device with the earliest deadline (call this from loop())
+/// @return true if a sample was written to the buffer, false otherwise
+bool AlicatPoller::update() {
+  if (_deviceCount == 0) return false;
+
+  unsigned long now = millis();
+
+  // spread the first polls over each interval so equal intervals do not poll in bursts
+  if (!_started) {
+    for (int i = 0; i < _deviceCount; i++) {
+      _releases[i] = now + i * deviceInterval(i) / _deviceCount;
+    }
+
+    _started = true;
+  }
+
+  int           deviceIndex = -1;
+  unsigned long deadline    = 0;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    if ((long)(now - _releases[i]) < 0) continue;
+
+    unsigned long deviceDeadline = _releases[i] + deviceInterval(i);
+
+    if (deviceIndex < 0 || (long)(deviceDeadline - deadline) < 0) {
+      deviceIndex = i;
+      deadline    = deviceDeadline;
+    }
+  }
+
+  if (deviceIndex < 0) return false;
+
+  // a poll is one block read of the status and statistics
+  if (_budget != NULL && !_budget->tryAcquire(_budgetUser, 1)) return false;
+
+  // a device that fell more than one interval behind starts over instead of catching up
+  _releases[deviceIndex] = deadline;
+
+  if ((long)(now - _releases[deviceIndex]) >= (long)deviceInterval(deviceIndex)) _releases[deviceIndex] = now;
+
+  AlicatModbusRTU* device = _devices[deviceIndex];
+  bool             ok     = device->pollSample(_buffer);
+
+  if ((long)(millis() - deadline) > 0) _deadlineMisses++;
+
+  _changedChannels = 0;
+
+  if (!ok) return false;
+
+  int row = _buffer.newestRow();
+
+  if (_monitor != NULL) _monitor->observe(*device, _buffer.status[row]);
+
+  _changedChannels = _deadband != NULL ? _deadband->check(*device, _buffer, row) : DEADBAND_ALL_CHANNELS;
+
+  // slots always get the latest reading, their timestamp tells readers how fresh it is
+  if (_slots != NULL) {
+    AlicatSnapshot snapshot;
+
+    _buffer.getSnapshot(row, &snapshot);
+    _slots[deviceIndex].publish(snapshot);
+  }
+
+  return true;
+}
+
+
+
+unsigned long AlicatPoller::deviceInterval(int index) {
+  return _intervals[index] != 0 ? _intervals[index] : _pollInterval;
+}
@@ -0,0 +1,63 @@
+#ifndef AlicatPoller_h
+    #define AlicatPoller_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+    #include <AlicatSampleBuffer.h>
+    #include <AlicatBusBudget.h>
+    #include <AlicatSnapshotSlot.h>
+    #include <AlicatBusModel.h>
+    #include <AlicatStatusMonitor.h>
+    #include <AlicatDeadband.h>
+
+    #define MAX_POLLER_DEVICES                              16
+
+    // Polls a set of Alicat devices sharing one bus and writes every reading
+    // straight into an AlicatSampleBuffer. Call update() from loop(); at most
+    // one device is polled per call so the rest of the sketch keeps running.
+    // Each device has its own poll interval, its deadline is the end of that
+    // interval and the released poll with the earliest deadline goes first.
+    // With an AlicatBusModel attached, utilization() and isFeasible() tell up
+    // front whether the bus can keep up with the requested intervals.
+    // With an AlicatDeadband attached every poll still lands in the buffer
+    // and the snapshot slots, but changedChannels() only reports the channels
+    // that moved past a deadband, for the consumers downstream (bus group
+    // queues, telemetry encoder).
+    class AlicatPoller {
+        private:
+            AlicatSampleBuffer& _buffer;
+            AlicatBusBudget*    _budget;
+            int                 _budgetUser;
+            AlicatSnapshotSlot* _slots;
+            AlicatBusModel*     _model;
+            AlicatStatusMonitor* _monitor;
+            AlicatDeadband*     _deadband;
+            uint8_t             _changedChannels;
+            AlicatModbusRTU*    _devices[MAX_POLLER_DEVICES];
+            unsigned long       _intervals[MAX_POLLER_DEVICES];     // 0 follows _pollInterval
+            unsigned long       _releases[MAX_POLLER_DEVICES];      // time the next poll of the device may start
+            int                 _deviceCount;
+            bool                _started;
+            unsigned long       _pollInterval;
+            unsigned long       _deadlineMisses;
+
+            unsigned long deviceInterval(int index);
+
+        public:
+                 AlicatPoller(AlicatSampleBuffer& buffer, unsigned long pollInterval);
+            bool addDevice(AlicatModbusRTU& device);
+            bool addDevice(AlicatModbusRTU& device, unsigned long pollInterval);
+            int  deviceCount();
+            AlicatSampleBuffer& buffer();
+            void setPollInterval(unsigned long pollInterval);
+            bool setBusBudget(AlicatBusBudget* budget, float share = 0.0);
+            void setSnapshotSlots(AlicatSnapshotSlot* slots);
+            void setBusModel(AlicatBusModel* model);
+            void setStatusMonitor(AlicatStatusMonitor* monitor);
+            void setDeadband(AlicatDeadband* deadband);
+            uint8_t changedChannels();
+            float utilization();
+            bool isFeasible();
+            unsigned long deadlineMisses();
+            bool update();
+    };
+#endif
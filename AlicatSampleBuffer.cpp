@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include <AlicatSampleBuffer.h>
+
+
+
+/// @brief Initialize an empty sample buffer
+AlicatSampleBuffer::AlicatSampleBuffer() {
+  clear();
+}
+
+
+
+/// @brief Reserve the next row of the buffer, overwriting the oldest row when the buffer is full
+/// @param sampleTimestamp time the sample was taken (ms)
+/// @param sampleDevice Modbus ID of the device the sample was taken from
+/// @return index of the reserved row, channel values of the row are reset to NAN / 0
+int AlicatSampleBuffer::append(unsigned long sampleTimestamp, uint8_t sampleDevice) {
+  int row = _head;
+
+  timestamp[row]      = sampleTimestamp;
+  device[row]         = sampleDevice;
+  pressure[row]       = NAN;
+  temperature[row]    = NAN;
+  volumetricFlow[row] = NAN;
+  massFlow[row]       = NAN;
+  setpoint[row]       = NAN;
+  status[row]         = 0;
+
+  _head = (_head + 1) % SAMPLE_BUFFER_CAPACITY;
+
+  if (_size < SAMPLE_BUFFER_CAPACITY) _size++;
+
+  return row;
+}
+
+
+
+/// @brief Get the row index of a sample by age
+/// @param age 0 for the oldest sample held, size()-1 for the newest
+/// @return row index into the channel arrays, -1 if age is out of bounds
+int AlicatSampleBuffer::rowAt(int age) {
+  if (age < 0 || age >= _size) return -1;
+
+  return (_head - _size + age + SAMPLE_BUFFER_CAPACITY) % SAMPLE_BUFFER_CAPACITY;
+}
+
+
+
+/// @brief Get the row index of the most recently appended sample
+/// @return row index into the channel arrays, -1 if the buffer is empty
+int AlicatSampleBuffer::newestRow() {
+  return rowAt(_size - 1);
+}
+
+
+
+/// @brief Copy one row of the buffer into a snapshot
+/// @param row row index into the channel arrays
+/// @param snapshot receives the row, the bus field is set to 0
+void AlicatSampleBuffer::getSnapshot(int row, AlicatSnapshot *snapshot) {
+  snapshot->timestamp      = timestamp[row];
+  snapshot->device         = device[row];
+  snapshot->bus            = 0;
+  snapshot->pressure       = pressure[row];
+  snapshot->temperature    = temperature[row];
+  snapshot->volumetricFlow = volumetricFlow[row];
+  snapshot->massFlow       = massFlow[row];
+  snapshot->setpoint       = setpoint[row];
+  snapshot->status         = status[row];
+}
+
+
+
+/// @brief Get the array of a float channel
+/// @param channel channel index (see SAMPLE_CHANNEL_* constants, except SAMPLE_CHANNEL_STATUS)
+/// @return channel array, NULL for the status or an unknown channel
+float* AlicatSampleBuffer::column(int channel) {
+  switch (channel) {
+    case SAMPLE_CHANNEL_PRESSURE:        return pressure;
+    case SAMPLE_CHANNEL_TEMPERATURE:     return temperature;
+    case SAMPLE_CHANNEL_VOLUMETRIC_FLOW: return volumetricFlow;
+    case SAMPLE_CHANNEL_MASS_FLOW:       return massFlow;
+    case SAMPLE_CHANNEL_SETPOINT:        return setpoint;
+    default:                             return NULL;
+  }
+}
+
+
+
+/// @brief Get the number of valid samples in the buffer
+/// @return number of samples (0-SAMPLE_BUFFER_CAPACITY)
+int AlicatSampleBuffer::size() {
+  return _size;
+}
+
+
+
+/// @brief Get the number of rows the buffer can hold
+/// @return SAMPLE_BUFFER_CAPACITY
+int AlicatSampleBuffer::capacity() {
+  return SAMPLE_BUFFER_CAPACITY;
+}
+
+
+
+/// @brief Check if the next append will overwrite the oldest sample
+/// @return true if the buffer is full, false otherwise
+bool AlicatSampleBuffer::isFull() {
+  return _size == SAMPLE_BUFFER_CAPACITY;
+}
+
+
+
+/// @brief Discard all samples
+void AlicatSampleBuffer::clear() {
+  _head = 0;
+  _size = 0;
+}
@@ -0,0 +1,59 @@
+#ifndef AlicatSampleBuffer_h
+    #define AlicatSampleBuffer_h
+    #include <Arduino.h>
+
+    #define SAMPLE_BUFFER_CAPACITY                          32      // Rows kept in the ring buffer before the oldest is overwritten
+
+    #define SAMPLE_CHANNEL_PRESSURE                         0
+    #define SAMPLE_CHANNEL_TEMPERATURE                      1
+    #define SAMPLE_CHANNEL_VOLUMETRIC_FLOW                  2
+    #define SAMPLE_CHANNEL_MASS_FLOW                        3
+    #define SAMPLE_CHANNEL_SETPOINT                         4
+    #define SAMPLE_CHANNEL_STATUS                           5
+    #define SAMPLE_CHANNEL_COUNT                            6
+
+    // One row of the sample buffer as a plain struct, used where a reading is
+    // handed over as a whole (queues, snapshot slots, gateway cache).
+    struct AlicatSnapshot {
+        unsigned long       timestamp;
+        uint8_t             device;
+        uint8_t             bus;
+        float               pressure;
+        float               temperature;
+        float               volumetricFlow;
+        float               massFlow;
+        float               setpoint;
+        uint16_t            status;
+    };
+
+    // Structure-of-arrays ring buffer of polled readings. Each channel is a
+    // separate array so consumers that scan one channel (filtering, export)
+    // touch only that channel's memory. All storage is allocated up front.
+    // Channels a device does not report are stored as NAN.
+    class AlicatSampleBuffer {
+        private:
+            int                 _head;          // next row to be written
+            int                 _size;          // number of valid rows
+
+        public:
+            unsigned long       timestamp[SAMPLE_BUFFER_CAPACITY];
+            uint8_t             device[SAMPLE_BUFFER_CAPACITY];
+            float               pressure[SAMPLE_BUFFER_CAPACITY];
+            float               temperature[SAMPLE_BUFFER_CAPACITY];
+            float               volumetricFlow[SAMPLE_BUFFER_CAPACITY];
+            float               massFlow[SAMPLE_BUFFER_CAPACITY];
+            float               setpoint[SAMPLE_BUFFER_CAPACITY];
+            uint16_t            status[SAMPLE_BUFFER_CAPACITY];
+
+                 AlicatSampleBuffer();
+            int  append(unsigned long sampleTimestamp, uint8_t sampleDevice);
+            int  rowAt(int age);
+            int  newestRow();
+            void getSnapshot(int row, AlicatSnapshot *snapshot);
+            float* column(int channel);
+            int  size();
+            int  capacity();
+            bool isFull();
+            void clear();
+    };
+#endif
@@ -0,0 +1,243 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatSequence.h>
+
+#define STEP_RESULT_PENDING                             0
+#define STEP_RESULT_DONE                                1
+#define STEP_RESULT_FAILED                              2
+
+
+
+/// @brief Initialize an empty sequence
+/// @param device handle to the AlicatModbusRTU object the sequence runs on
+AlicatSequence::AlicatSequence(AlicatModbusRTU& device)
+: _device(device)
+{
+  _pollInterval = 50;
+
+  clear();
+}
+
+
+
+/// @brief Set how often wait steps read the status register
+/// @param pollInterval status poll interval (ms)
+void AlicatSequence::setPollInterval(unsigned long pollInterval) {
+  _pollInterval = pollInterval;
+}
+
+
+
+/// @brief Append a step that writes the setpoint
+/// @param setpoint desired setpoint value
+/// @return true if the step was added, false if the sequence is full
+bool AlicatSequence::addSetSetpoint(float setpoint) {
+  return addStep(SEQUENCE_STEP_SET_SETPOINT, 0, 0, setpoint, 0);
+}
+
+
+
+/// @brief Append a step that changes the gas with SPECIAL_COMMAND_CHANGE_GAS_NUMBER, fails if the command is rejected
+/// @param gasIndex index of the gas from the gas table (0-210)
+/// @return true if the step was added, false if the sequence is full
+bool AlicatSequence::addChangeGas(uint16_t gasIndex) {
+  return addStep(SEQUENCE_STEP_CHANGE_GAS, gasIndex, 0, 0.0, 0);
+}
+
+
+
+/// @brief Append a step that sends a special command, fails if the command is rejected
+/// @param command id of the special command (see SPECIAL_COMMAND_* constants)
+/// @param argument argument of the special command
+/// @return true if the step was added, false if the sequence is full
+bool AlicatSequence::addSpecialCommand(uint16_t command, uint16_t argument) {
+  return addStep(SEQUENCE_STEP_SPECIAL_COMMAND, command, argument, 0.0, 0);
+}
+
+
+
+/// @brief Append a step that waits until none of the given status bits are set
+/// @param statusMask status bits to watch (see STATUS_BIT_* constants)
+/// @param timeout time after which the step fails (ms)
+/// @return true if the step was added, false if the sequence is full
+bool AlicatSequence::addWaitStatusClear(uint16_t statusMask, unsigned long timeout) {
+  return addStep(SEQUENCE_STEP_WAIT_STATUS_CLEAR, statusMask, 0, 0.0, timeout);
+}
+
+
+
+/// @brief Append a step that waits until any of the given status bits is set
+/// @param statusMask status bits to watch (see STATUS_BIT_* constants)
+/// @param timeout time after which the step fails (ms)
+/// @return true if the step was added, false if the sequence is full
+bool AlicatSequence::addWaitStatusSet(uint16_t statusMask, unsigned long timeout) {
+  return addStep(SEQUENCE_STEP_WAIT_STATUS_SET, statusMask, 0, 0.0, timeout);
+}
+
+
+
+/// @brief Append a step that reads the gas number back and fails if it differs
+/// @param gasIndex expected gas index
+/// @return true if the step was added, false if the sequence is full
+bool AlicatSequence::addVerifyGas(uint16_t gasIndex) {
+  return addStep(SEQUENCE_STEP_VERIFY_GAS, gasIndex, 0, 0.0, 0);
+}
+
+
+
+/// @brief Append a step that waits without using the bus
+/// @param duration wait time (ms)
+/// @return true if the step was added, false if the sequence is full
+bool AlicatSequence::addDelay(unsigned long duration) {
+  return addStep(SEQUENCE_STEP_DELAY, 0, 0, 0.0, duration);
+}
+
+
+
+/// @brief Remove all steps
+void AlicatSequence::clear() {
+  _stepCount   = 0;
+  _currentStep = 0;
+  _state       = SEQUENCE_STATE_IDLE;
+}
+
+
+
+/// @brief Start the sequence at its first step
+void AlicatSequence::start() {
+  _currentStep   = 0;
+  _stepStartTime = millis();
+  _lastPollTime  = _stepStartTime - _pollInterval;
+  _commandSent   = false;
+  _state         = _stepCount > 0 ? SEQUENCE_STATE_RUNNING : SEQUENCE_STATE_DONE;
+}
+
+
+
+/// @brief Advance the sequence by at most one bus transaction (call this from loop())
+/// @return sequence state (see SEQUENCE_STATE_* constants)
+int AlicatSequence::update() {
+  if (_state != SEQUENCE_STATE_RUNNING) return _state;
+
+  unsigned long now    = millis();
+  int           result = runStep(_steps[_currentStep], now);
+
+  if (result == STEP_RESULT_FAILED) {
+    _state = SEQUENCE_STATE_FAILED;
+  } else if (result == STEP_RESULT_DONE) {
+    _currentStep++;
+    _stepStartTime = now;
+    _lastPollTime  = now - _pollInterval;
+    _commandSent   = false;
+
+    if (_currentStep >= _stepCount) _state = SEQUENCE_STATE_DONE;
+  }
+
+  return _state;
+}
+
+
+
+/// @brief Get the state of the sequence
+/// @return sequence state (see SEQUENCE_STATE_* constants)
+int AlicatSequence::state() {
+  return _state;
+}
+
+
+
+/// @brief Get the step being run, or the step that failed
+/// @return step index (0 to number of steps)
+int AlicatSequence::currentStep() {
+  return _currentStep;
+}
+
+
+
+bool AlicatSequence::addStep(uint8_t type, uint16_t argument, uint16_t argument2, float value, unsigned long timeout) {
+  if (_stepCount >= MAX_SEQUENCE_STEPS) return false;
+
+  Step& step = _steps[_stepCount++];
+
+  step.type      = type;
+  step.argument  = argument;
+  step.argument2 = argument2;
+  step.value     = value;
+  step.timeout   = timeout;
+
+  return true;
+}
+
+
+
+int AlicatSequence::runStep(Step& step, unsigned long now) {
+  switch (step.type) {
+    case SEQUENCE_STEP_SET_SETPOINT: {
+      uint16_t data[2];
+
+      if (!_device.deviceIsController()) return STEP_RESULT_FAILED;
+
+      AlicatModbusRTU::floatToRegisters(step.value, data);
+
+      return _device.writeRegisters(REGISTER_SETPOINT, data, 2) ? STEP_RESULT_DONE : STEP_RESULT_FAILED;
+    }
+
+    case SEQUENCE_STEP_CHANGE_GAS:
+      return runSpecialCommand(SPECIAL_COMMAND_CHANGE_GAS_NUMBER, step.argument);
+
+    case SEQUENCE_STEP_SPECIAL_COMMAND:
+      return runSpecialCommand(step.argument, step.argument2);
+
+    case SEQUENCE_STEP_WAIT_STATUS_CLEAR:
+    case SEQUENCE_STEP_WAIT_STATUS_SET: {
+      if (now - _stepStartTime >= step.timeout) return STEP_RESULT_FAILED;
+      if (now - _lastPollTime < _pollInterval) return STEP_RESULT_PENDING;
+
+      uint16_t status;
+
+      _lastPollTime = now;
+
+      if (!_device.readRegisters(REGISTER_DEVICE_STATUS, 1, &status)) return STEP_RESULT_PENDING;
+
+      bool anySet = status & step.argument;
+
+      if (step.type == SEQUENCE_STEP_WAIT_STATUS_CLEAR) return anySet ? STEP_RESULT_PENDING : STEP_RESULT_DONE;
+
+      return anySet ? STEP_RESULT_DONE : STEP_RESULT_PENDING;
+    }
+
+    case SEQUENCE_STEP_VERIFY_GAS: {
+      uint16_t gasIndex;
+
+      if (!_device.readRegisters(REGISTER_GAS_NUMBER, 1, &gasIndex)) return STEP_RESULT_FAILED;
+
+      return gasIndex == step.argument ? STEP_RESULT_DONE : STEP_RESULT_FAILED;
+    }
+
+    case SEQUENCE_STEP_DELAY:
+      return now - _stepStartTime >= step.timeout ? STEP_RESULT_DONE : STEP_RESULT_PENDING;
+  }
+
+  return STEP_RESULT_FAILED;
+}
+
+
+
+// same exchange as AlicatModbusRTU::sendSpecialCommand, split over two calls
+int AlicatSequence::runSpecialCommand(uint16_t command, uint16_t argument) {
+  if (!_commandSent) {
+    uint16_t data[2] = { command, argument };
+
+    if (!_device.writeRegisters(REGISTER_COMMAND_ID, data, 2)) return STEP_RESULT_FAILED;
+
+    _commandSent = true;
+
+    return STEP_RESULT_PENDING;
+  }
+
+  uint16_t status;
+
+  if (!_device.readRegisters(REGISTER_COMMAND_ARGUMENT, 1, &status)) return STEP_RESULT_FAILED;
+
+  return _device.handleSpecialCommandStatusCode(status) ? STEP_RESULT_DONE : STEP_RESULT_FAILED;
+}
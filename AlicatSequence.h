@@ -0,0 +1,67 @@
+#ifndef AlicatSequence_h
+    #define AlicatSequence_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    #define MAX_SEQUENCE_STEPS                              8
+
+    #define SEQUENCE_STEP_SET_SETPOINT                      0
+    #define SEQUENCE_STEP_CHANGE_GAS                        1
+    #define SEQUENCE_STEP_SPECIAL_COMMAND                   2
+    #define SEQUENCE_STEP_WAIT_STATUS_CLEAR                 3
+    #define SEQUENCE_STEP_WAIT_STATUS_SET                   4
+    #define SEQUENCE_STEP_VERIFY_GAS                        5
+    #define SEQUENCE_STEP_DELAY                             6
+
+    #define SEQUENCE_STATE_IDLE                             0
+    #define SEQUENCE_STATE_RUNNING                          1
+    #define SEQUENCE_STATE_DONE                             2
+    #define SEQUENCE_STATE_FAILED                           3
+
+    // A short per-device script (e.g. change gas, wait for the status to
+    // clear, verify the gas) that runs without blocking loop(). update()
+    // performs at most one bus transaction per call (a special command is
+    // written in one call and its result read in the next) and waits are checked
+    // against millis(), so sequences on many devices and buses interleave in
+    // one loop without a thread per device.
+    class AlicatSequence {
+        private:
+            struct Step {
+                uint8_t         type;
+                uint16_t        argument;
+                uint16_t        argument2;
+                float           value;
+                unsigned long   timeout;
+            };
+
+            AlicatModbusRTU&    _device;
+            Step                _steps[MAX_SEQUENCE_STEPS];
+            int                 _stepCount;
+            int                 _currentStep;
+            int                 _state;
+            bool                _commandSent;   // special command written, result not read yet
+            unsigned long       _stepStartTime;
+            unsigned long       _lastPollTime;
+            unsigned long       _pollInterval;
+
+            bool addStep(uint8_t type, uint16_t argument, uint16_t argument2, float value, unsigned long timeout);
+            int  runStep(Step& step, unsigned long now);
+            int  runSpecialCommand(uint16_t command, uint16_t argument);
+
+        public:
+                 AlicatSequence(AlicatModbusRTU& device);
+            void setPollInterval(unsigned long pollInterval);
+            bool addSetSetpoint(float setpoint);
+            bool addChangeGas(uint16_t gasIndex);
+            bool addSpecialCommand(uint16_t command, uint16_t argument);
+            bool addWaitStatusClear(uint16_t statusMask, unsigned long timeout);
+            bool addWaitStatusSet(uint16_t statusMask, unsigned long timeout);
+            bool addVerifyGas(uint16_t gasIndex);
+            bool addDelay(unsigned long duration);
+            void clear();
+            void start();
+            int  update();
+            int  state();
+            int  currentStep();
+    };
+#endif
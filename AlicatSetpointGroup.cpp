@@ -0,0 +1,155 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatSetpointGroup.h>
+
+
+
+/// @brief Initialize an empty setpoint group
+AlicatSetpointGroup::AlicatSetpointGroup() {
+  _deviceCount    = 0;
+  _failedCount    = 0;
+  _allowBroadcast = false;
+  _lastSkew       = 0;
+}
+
+
+
+/// @brief Add a controller to the group (Controller devices only)
+/// @param device handle to the AlicatModbusRTU object, must share the bus with the other members
+/// @return member index used by stage(), -1 if the group is full or the device is not a controller
+int AlicatSetpointGroup::addDevice(AlicatModbusRTU& device) {
+  if (_deviceCount >= MAX_SETPOINT_GROUP_DEVICES || !device.deviceIsController()) return -1;
+
+  _devices[_deviceCount] = &device;
+  _staged[_deviceCount]  = false;
+  _failed[_deviceCount]  = false;
+
+  return _deviceCount++;
+}
+
+
+
+/// @brief Allow commit() to use a single broadcast write when every member gets the same setpoint
+/// @param allowBroadcast true to allow broadcast writes (reaches all devices on the bus)
+void AlicatSetpointGroup::setAllowBroadcast(bool allowBroadcast) {
+  _allowBroadcast = allowBroadcast;
+}
+
+
+
+/// @brief Stage the setpoint of one member, nothing is sent until commit()
+/// @param member member index returned by addDevice()
+/// @param setpoint desired setpoint value
+/// @return true if the setpoint was staged, false if the member index is invalid
+bool AlicatSetpointGroup::stage(int member, float setpoint) {
+  if (member < 0 || member >= _deviceCount) return false;
+
+  AlicatModbusRTU::floatToRegisters(setpoint, _frames[member]);
+
+  _setpoints[member] = setpoint;
+  _staged[member]    = true;
+
+  return true;
+}
+
+
+
+/// @brief Stage the same setpoint for every member
+/// @param setpoint desired setpoint value
+void AlicatSetpointGroup::stageAll(float setpoint) {
+  for (int i = 0; i < _deviceCount; i++) stage(i, setpoint);
+}
+
+
+
+/// @brief Send all staged setpoints back to back and clear the staging area
+/// @return number of frames sent successfully (a broadcast counts as one frame)
+int AlicatSetpointGroup::commit() {
+  int  stagedCount = 0;
+  bool sameValue   = true;
+  int  first       = -1;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    if (!_staged[i]) continue;
+
+    if (first < 0) first = i;
+    else if (_setpoints[i] != _setpoints[first]) sameValue = false;
+
+    stagedCount++;
+  }
+
+  if (stagedCount == 0) return 0;
+
+  _lastSkew    = 0;
+  _failedCount = 0;
+
+  for (int i = 0; i < _deviceCount; i++) _failed[i] = false;
+
+  if (_allowBroadcast && sameValue && stagedCount == _deviceCount && stagedCount > 1) {
+    bool ok = _devices[first]->broadcastRegisters(REGISTER_SETPOINT, _frames[first], 2);
+
+    for (int i = 0; i < _deviceCount; i++) {
+      _staged[i] = false;
+      _failed[i] = !ok;
+    }
+
+    if (ok) return 1;
+
+    _failedCount = _deviceCount;
+
+    return 0;
+  }
+
+  unsigned long firstDone = 0;
+  unsigned long lastDone  = 0;
+  int           sent      = 0;
+
+  for (int i = 0; i < _deviceCount; i++) {
+    if (!_staged[i]) continue;
+
+    _staged[i] = false;
+
+    if (!_devices[i]->writeRegisters(REGISTER_SETPOINT, _frames[i], 2)) {
+      _failed[i] = true;
+      _failedCount++;
+
+      continue;
+    }
+
+    // the skew only spans the members that received their setpoint
+    lastDone = micros();
+
+    if (sent++ == 0) firstDone = lastDone;
+  }
+
+  _lastSkew = lastDone - firstDone;
+
+  return sent;
+}
+
+
+
+/// @brief Get the skew of the last commit()
+/// @return time between the first and the last successful member write completing (us), 0 for a broadcast
+unsigned long AlicatSetpointGroup::lastSkew() {
+  return _lastSkew;
+}
+
+
+
+/// @brief Check whether the setpoint of a member failed to reach it in the last commit()
+/// @param member member index returned by addDevice()
+/// @return true if the write (or the broadcast) failed, false if it succeeded, was not staged or the member index is invalid
+bool AlicatSetpointGroup::failed(int member) {
+  if (member < 0 || member >= _deviceCount) return false;
+
+  return _failed[member];
+}
+
+
+
+/// @brief Get the number of members whose setpoint failed to reach them in the last commit()
+/// @return failed member count
+int AlicatSetpointGroup::failedCount() {
+  return _failedCount;
+}
@@ -0,0 +1,40 @@
+#ifndef AlicatSetpointGroup_h
+    #define AlicatSetpointGroup_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    #define MAX_SETPOINT_GROUP_DEVICES                      8
+
+    // Stages setpoints for a group of controllers on one bus and applies them
+    // together. All frames are encoded before the first one is sent, so
+    // commit() issues the writes back to back; the skew between the first and
+    // the last controller receiving its setpoint is measured and reported.
+    // Members whose write failed are reported by failed() until the next
+    // commit().
+    // With broadcast enabled and the same value staged for every member, a
+    // single write to Modbus ID 0 is sent instead. Note that a broadcast
+    // reaches every device on the bus, not only the members of the group.
+    class AlicatSetpointGroup {
+        private:
+            AlicatModbusRTU*    _devices[MAX_SETPOINT_GROUP_DEVICES];
+            uint16_t            _frames[MAX_SETPOINT_GROUP_DEVICES][2];
+            bool                _staged[MAX_SETPOINT_GROUP_DEVICES];
+            bool                _failed[MAX_SETPOINT_GROUP_DEVICES];
+            float               _setpoints[MAX_SETPOINT_GROUP_DEVICES];
+            int                 _deviceCount;
+            int                 _failedCount;
+            bool                _allowBroadcast;
+            unsigned long       _lastSkew;
+
+        public:
+                 AlicatSetpointGroup();
+            int  addDevice(AlicatModbusRTU& device);
+            void setAllowBroadcast(bool allowBroadcast);
+            bool stage(int member, float setpoint);
+            void stageAll(float setpoint);
+            int  commit();
+            unsigned long lastSkew();
+            bool failed(int member);
+            int  failedCount();
+    };
+#endif
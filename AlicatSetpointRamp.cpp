@@ -0,0 +1,154 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatBusBudget.h>
+#include <AlicatSetpointRamp.h>
+
+
+
+/// @brief Initialize the AlicatSetpointRamp object (Controller devices only)
+/// @param device handle to the AlicatModbusRTU object of the controller
+AlicatSetpointRamp::AlicatSetpointRamp(AlicatModbusRTU& device)
+: _device(device)
+{
+  _budget           = NULL;
+  _budgetUser       = -1;
+  _quantum          = 0.0;
+  _minWriteInterval = 0;
+  _writeCount       = 0;
+  _running          = false;
+  _from             = 0.0;
+  _to               = 0.0;
+  _rate             = 0.0;
+  _lastWritten      = 0.0;
+}
+
+
+
+/// @brief Set the smallest setpoint change worth a bus write
+/// @param quantum minimum setpoint change between two writes (setpoint units)
+void AlicatSetpointRamp::setQuantum(float quantum) {
+  _quantum = quantum < 0.0 ? 0.0 : quantum;
+}
+
+
+
+/// @brief Set the minimum time between two setpoint writes
+/// @param minWriteInterval minimum write interval (ms)
+void AlicatSetpointRamp::setMinWriteInterval(unsigned long minWriteInterval) {
+  _minWriteInterval = minWriteInterval;
+}
+
+
+
+/// @brief Share a bus budget with the other users of the bus
+/// @param budget handle to the AlicatBusBudget object, NULL for no limit
+/// @param share fraction of the bus rate reserved for this user (0 for the shared pool only)
+/// @return true if the budget was attached, false if it cannot grant the share (the previous budget is kept)
+bool AlicatSetpointRamp::setBusBudget(AlicatBusBudget* budget, float share) {
+  int user = -1;
+
+  if (budget != NULL) {
+    user = budget->addUser(share, 1);
+
+    if (user < 0) return false;
+  }
+
+  _budget     = budget;
+  _budgetUser = user;
+
+  return true;
+}
+
+
+
+/// @brief Start a ramp, the start value is written on the next update()
+/// @param from setpoint at the start of the ramp
+/// @param to setpoint at the end of the ramp
+/// @param ratePerSecond ramp rate (setpoint units per second, > 0; 0 jumps straight to the end value)
+void AlicatSetpointRamp::start(float from, float to, float ratePerSecond) {
+  _from          = from;
+  _to            = to;
+  _rate          = ratePerSecond < 0.0 ? -ratePerSecond : ratePerSecond;
+  _startTime     = millis();
+  _lastWriteTime = _startTime - _minWriteInterval;
+  _lastWritten   = NAN;
+  _running       = true;
+}
+
+
+
+/// @brief Stop the ramp, the setpoint stays at the last written value
+void AlicatSetpointRamp::stop() {
+  _running = false;
+}
+
+
+
+/// @brief Advance the ramp (call this from loop())
+/// @return true if a setpoint was written to the device, false otherwise
+bool AlicatSetpointRamp::update() {
+  if (!_running) return false;
+
+  float target    = targetSetpoint();
+  bool  finalStep = target == _to;
+
+  if (!isnan(_lastWritten)) {
+    float change = target - _lastWritten;
+    if (change < 0.0) change = -change;
+
+    if (change == 0.0 || (change < _quantum && !finalStep)) return false;
+  }
+
+  unsigned long now = millis();
+
+  if (now - _lastWriteTime < _minWriteInterval) return false;
+  if (_budget != NULL && !_budget->tryAcquire(_budgetUser, 1)) return false;
+
+  _device.setSetpoint(target);
+
+  _lastWritten   = target;
+  _lastWriteTime = now;
+  _writeCount++;
+
+  if (finalStep) _running = false;
+
+  return true;
+}
+
+
+
+/// @brief Check if the ramp still has setpoints to write
+/// @return true until the end value has been written or the ramp is stopped
+bool AlicatSetpointRamp::isRunning() {
+  return _running;
+}
+
+
+
+/// @brief Get the setpoint of the trajectory at the current time
+/// @return ramp setpoint, clamped to the end value
+float AlicatSetpointRamp::targetSetpoint() {
+  if (_rate == 0.0) return _to;
+
+  float travelled = _rate * (millis() - _startTime) / 1000.0;
+
+  if (_to >= _from) return _from + travelled >= _to ? _to : _from + travelled;
+
+  return _from - travelled <= _to ? _to : _from - travelled;
+}
+
+
+
+/// @brief Get the setpoint last written to the device
+/// @return last written setpoint, NAN if nothing has been written since start()
+float AlicatSetpointRamp::lastWrittenSetpoint() {
+  return _lastWritten;
+}
+
+
+
+/// @brief Get the number of setpoint writes issued by the ramp
+/// @return write count since the object was created
+unsigned long AlicatSetpointRamp::writeCount() {
+  return _writeCount;
+}
@@ -0,0 +1,41 @@
+#ifndef AlicatSetpointRamp_h
+    #define AlicatSetpointRamp_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+    #include <AlicatBusBudget.h>
+
+    // Moves the setpoint of a controller along a linear ramp. The trajectory
+    // is computed locally and setSetpoint is only called when the setpoint
+    // has moved by at least the quantum since the last write, no more often
+    // than the minimum write interval and only when the (optional) bus budget
+    // has a token to spare. The final setpoint is always written.
+    class AlicatSetpointRamp {
+        private:
+            AlicatModbusRTU&    _device;
+            AlicatBusBudget*    _budget;
+            int                 _budgetUser;
+            float               _from;
+            float               _to;
+            float               _rate;
+            float               _quantum;
+            float               _lastWritten;
+            unsigned long       _startTime;
+            unsigned long       _lastWriteTime;
+            unsigned long       _minWriteInterval;
+            unsigned long       _writeCount;
+            bool                _running;
+
+        public:
+                  AlicatSetpointRamp(AlicatModbusRTU& device);
+            void  setQuantum(float quantum);
+            void  setMinWriteInterval(unsigned long minWriteInterval);
+            bool  setBusBudget(AlicatBusBudget* budget, float share = 0.0);
+            void  start(float from, float to, float ratePerSecond);
+            void  stop();
+            bool  update();
+            bool  isRunning();
+            float targetSetpoint();
+            float lastWrittenSetpoint();
+            unsigned long writeCount();
+    };
+#endif
@@ -0,0 +1,74 @@
+#include <Arduino.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatSnapshotQueue.h>
+
+
+
+/// @brief Initialize an empty queue
+AlicatSnapshotQueue::AlicatSnapshotQueue() {
+  _head    = 0;
+  _tail    = 0;
+  _dropped = 0;
+}
+
+
+
+/// @brief Add a snapshot to the queue (producer side only)
+/// @param snapshot snapshot to add
+/// @return true if the snapshot was queued, false if the queue is full (the snapshot is dropped)
+bool AlicatSnapshotQueue::push(const AlicatSnapshot& snapshot) {
+  uint8_t head = _head;
+  uint8_t next = (head + 1) & (SNAPSHOT_QUEUE_CAPACITY - 1);
+
+  if (next == _tail) {
+    _dropped++;
+
+    return false;
+  }
+
+  _slots[head] = snapshot;
+
+  // the slot must be complete before the consumer can see the new head
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  _head = next;
+
+  return true;
+}
+
+
+
+/// @brief Take the oldest snapshot from the queue (consumer side only)
+/// @param snapshot receives the snapshot
+/// @return true if a snapshot was taken, false if the queue is empty
+bool AlicatSnapshotQueue::pop(AlicatSnapshot *snapshot) {
+  uint8_t tail = _tail;
+
+  if (tail == _head) return false;
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  *snapshot = _slots[tail];
+
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  _tail = (tail + 1) & (SNAPSHOT_QUEUE_CAPACITY - 1);
+
+  return true;
+}
+
+
+
+/// @brief Get the number of queued snapshots
+/// @return queued snapshots (may be stale by the time it is used)
+int AlicatSnapshotQueue::size() {
+  return (_head - _tail) & (SNAPSHOT_QUEUE_CAPACITY - 1);
+}
+
+
+
+/// @brief Get the number of snapshots dropped because the queue was full
+/// @return dropped snapshots (producer side counter)
+unsigned long AlicatSnapshotQueue::dropped() {
+  return _dropped;
+}
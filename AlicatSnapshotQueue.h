@@ -0,0 +1,26 @@
+#ifndef AlicatSnapshotQueue_h
+    #define AlicatSnapshotQueue_h
+    #include <Arduino.h>
+    #include <AlicatSampleBuffer.h>
+
+    #define SNAPSHOT_QUEUE_CAPACITY                         16      // must be a power of two, one slot is kept free
+
+    // Lock-free single-producer / single-consumer queue of snapshots. The
+    // producer only writes _head, the consumer only writes _tail, so push()
+    // and pop() can run in different tasks, cores or an ISR without locks.
+    // When the queue is full new snapshots are dropped and counted.
+    class AlicatSnapshotQueue {
+        private:
+            AlicatSnapshot      _slots[SNAPSHOT_QUEUE_CAPACITY];
+            volatile uint8_t    _head;
+            volatile uint8_t    _tail;
+            unsigned long       _dropped;
+
+        public:
+                 AlicatSnapshotQueue();
+            bool push(const AlicatSnapshot& snapshot);
+            bool pop(AlicatSnapshot *snapshot);
+            int  size();
+            unsigned long dropped();
+    };
+#endif
@@ -0,0 +1,85 @@
+#include <Arduino.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatSnapshotSlot.h>
+
+
+
+/// @brief Initialize an empty slot
+AlicatSnapshotSlot::AlicatSnapshotSlot() {
+  memset(_copies, 0, sizeof(_copies));
+
+  _sequence     = 0;
+  _published    = false;
+  _readRetries  = 0;
+  _readFailures = 0;
+}
+
+
+
+/// @brief Publish a new reading (single writer only)
+/// @param snapshot reading to publish
+void AlicatSnapshotSlot::publish(const AlicatSnapshot& snapshot) {
+  uint32_t sequence = __atomic_load_n(&_sequence, __ATOMIC_SEQ_CST);
+
+  // each step moves the readers to the copy that is not being written; the
+  // fence keeps the copy write from being reordered ahead of the bump
+  __atomic_store_n(&_sequence, sequence + 1, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  _copies[sequence & 1] = snapshot;
+
+  __atomic_store_n(&_sequence, sequence + 2, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  _copies[(sequence + 1) & 1] = snapshot;
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  _published = true;
+}
+
+
+
+/// @brief Read the latest reading without blocking the writer
+/// @param snapshot receives the reading
+/// @return true if a consistent reading was copied, false if nothing was published yet or the writer published during every attempt (snapshot may be overwritten)
+bool AlicatSnapshotSlot::read(AlicatSnapshot *snapshot) {
+  if (!_published) return false;
+
+  for (int attempt = 0; attempt < SNAPSHOT_SLOT_READ_ATTEMPTS; attempt++) {
+    uint32_t before = __atomic_load_n(&_sequence, __ATOMIC_SEQ_CST);
+
+    *snapshot = _copies[before & 1];
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&_sequence, __ATOMIC_SEQ_CST) == before) return true;
+
+    _readRetries++;
+  }
+
+  _readFailures++;
+
+  return false;
+}
+
+
+
+/// @brief Get the publication counter, readers can compare it with a previous value to detect new readings
+/// @return sequence number (advances by 2 per publication, wraps around after 2^31 publications)
+uint32_t AlicatSnapshotSlot::sequence() {
+  return __atomic_load_n(&_sequence, __ATOMIC_SEQ_CST);
+}
+
+
+
+/// @brief Get the number of read attempts that raced the writer
+/// @return retry count (contention indicator, not synchronized between readers)
+unsigned long AlicatSnapshotSlot::readRetries() {
+  return _readRetries;
+}
+
+
+
+/// @brief Get the number of reads that gave up after SNAPSHOT_SLOT_READ_ATTEMPTS attempts
+/// @return failure count (not synchronized between readers)
+unsigned long AlicatSnapshotSlot::readFailures() {
+  return _readFailures;
+}
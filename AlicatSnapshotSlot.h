@@ -0,0 +1,35 @@
+#ifndef AlicatSnapshotSlot_h
+    #define AlicatSnapshotSlot_h
+    #include <Arduino.h>
+    #include <AlicatSampleBuffer.h>
+
+    #define SNAPSHOT_SLOT_READ_ATTEMPTS                     4
+
+    // Latest reading of one device, published by a single writer (the poller)
+    // and read by any number of readers without locks. The slot keeps two
+    // copies of the reading and a 32-bit sequence whose low bit selects the
+    // copy readers use; the writer updates the other copy first (seqcount
+    // latch). The writer never waits, and a reader that interrupted the
+    // writer (e.g. in an ISR) always finds a complete copy on the first
+    // attempt. A reader only retries when a publish completes while it is
+    // copying, and gives up after SNAPSHOT_SLOT_READ_ATTEMPTS so it cannot
+    // spin forever: that only happens when the writer publishes back to back
+    // on another core faster than the reader can copy, and the reader then
+    // simply keeps its previous reading (see examples/SnapshotSlotBenchmark).
+    class AlicatSnapshotSlot {
+        private:
+            AlicatSnapshot      _copies[2];
+            volatile uint32_t   _sequence;      // low bit: copy the readers use
+            volatile bool       _published;
+            unsigned long       _readRetries;
+            unsigned long       _readFailures;
+
+        public:
+                     AlicatSnapshotSlot();
+            void     publish(const AlicatSnapshot& snapshot);
+            bool     read(AlicatSnapshot *snapshot);
+            uint32_t sequence();
+            unsigned long readRetries();
+            unsigned long readFailures();
+    };
+#endif
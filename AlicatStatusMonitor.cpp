@@ -0,0 +1,184 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatBusBudget.h>
+#include <AlicatStatusMonitor.h>
+
+
+
+/// @brief Initialize the AlicatStatusMonitor object
+/// @param slowInterval time between two status reads of a healthy device (ms)
+/// @param fastInterval time between two status reads of a device with a recent status bit (ms)
+AlicatStatusMonitor::AlicatStatusMonitor(unsigned long slowInterval, unsigned long fastInterval) {
+  _budget       = NULL;
+  _budgetUser   = -1;
+  _changed      = 0;
+  _deviceCount  = 0;
+  _nextDevice   = 0;
+  _slowInterval = slowInterval;
+  _fastInterval = fastInterval;
+  _holdTime     = 10000;
+  _statusReads  = 0;
+}
+
+
+
+/// @brief Add a device to the watch list, its first status read is due right away
+/// @param device handle to the AlicatModbusRTU object
+/// @return true if the device was added, false if the watch list is full
+bool AlicatStatusMonitor::addDevice(AlicatModbusRTU& device) {
+  if (_deviceCount >= MAX_STATUS_MONITOR_DEVICES) return false;
+
+  _devices[_deviceCount]   = &device;
+  _status[_deviceCount]    = 0;
+  _lastCheck[_deviceCount] = millis() - _slowInterval;
+  _seenSet[_deviceCount]   = false;
+  _deviceCount++;
+
+  return true;
+}
+
+
+
+/// @brief Set how long a device stays on the fast interval after a status bit was last seen set
+/// @param holdTime hold time (ms)
+void AlicatStatusMonitor::setHoldTime(unsigned long holdTime) {
+  _holdTime = holdTime;
+}
+
+
+
+/// @brief Share a bus budget with the other users of the bus
+/// @param budget handle to the AlicatBusBudget object, NULL for no limit
+/// @param share fraction of the bus rate reserved for this user (0 for the shared pool only)
+/// @return true if the budget was attached, false if it cannot grant the share (the previous budget is kept)
+bool AlicatStatusMonitor::setBusBudget(AlicatBusBudget* budget, float share) {
+  int user = -1;
+
+  if (budget != NULL) {
+    user = budget->addUser(share, 1);
+
+    if (user < 0) return false;
+  }
+
+  _budget     = budget;
+  _budgetUser = user;
+
+  return true;
+}
+
+
+
+/// @brief Pass on a status that was read anyway (e.g. with a poll), it counts as a status check
+/// @param device device the status belongs to, ignored if it is not on the watch list
+/// @param status value of REGISTER_DEVICE_STATUS
+void AlicatStatusMonitor::observe(AlicatModbusRTU& device, uint16_t status) {
+  int index = findDevice(device);
+
+  if (index < 0) return;
+
+  record(index, status, millis());
+}
+
+
+
+/// @brief Read the status of the next device that is due (call this from loop())
+/// @return true if a status was read, false otherwise
+bool AlicatStatusMonitor::update() {
+  unsigned long now = millis();
+
+  for (int n = 0; n < _deviceCount; n++) {
+    int index = (_nextDevice + n) % _deviceCount;
+
+    if (now - _lastCheck[index] < (isEscalated(index) ? _fastInterval : _slowInterval)) continue;
+
+    if (_budget != NULL && !_budget->tryAcquire(_budgetUser, 1)) return false;
+
+    uint16_t status;
+
+    _nextDevice = (index + 1) % _deviceCount;
+
+    if (!_devices[index]->readRegisters(REGISTER_DEVICE_STATUS, 1, &status)) {
+      // try again after a full interval rather than hammering a silent device
+      _lastCheck[index] = now;
+
+      return false;
+    }
+
+    _statusReads++;
+    record(index, status, now);
+
+    return true;
+  }
+
+  return false;
+}
+
+
+
+/// @brief Get a device whose status changed since it was last reported, and clear its change
+/// @return device index, in the order the devices were added, -1 if no status changed
+int AlicatStatusMonitor::changedDevice() {
+  for (int i = 0; i < _deviceCount; i++) {
+    if (_changed & (1 << i)) {
+      _changed &= ~(1 << i);
+
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+
+
+/// @brief Get the last known status of a device
+/// @param index device index, in the order the devices were added
+/// @return value of REGISTER_DEVICE_STATUS (see STATUS_BIT_* constants)
+uint16_t AlicatStatusMonitor::status(int index) {
+  if (index < 0 || index >= _deviceCount) return 0;
+
+  return _status[index];
+}
+
+
+
+/// @brief Check whether a device is on the fast interval
+/// @param index device index, in the order the devices were added
+/// @return true if a status bit was set within the hold time, false otherwise
+bool AlicatStatusMonitor::isEscalated(int index) {
+  if (index < 0 || index >= _deviceCount || !_seenSet[index]) return false;
+
+  return _status[index] != 0 || millis() - _lastSet[index] < _holdTime;
+}
+
+
+
+/// @brief Get the number of status reads the monitor made itself
+/// @return status read count
+unsigned long AlicatStatusMonitor::statusReads() {
+  return _statusReads;
+}
+
+
+
+int AlicatStatusMonitor::findDevice(AlicatModbusRTU& device) {
+  for (int i = 0; i < _deviceCount; i++) {
+    if (_devices[i] == &device) return i;
+  }
+
+  return -1;
+}
+
+
+
+void AlicatStatusMonitor::record(int index, uint16_t status, unsigned long now) {
+  if (status != _status[index]) _changed |= (1 << index);
+
+  if (status != 0) {
+    _lastSet[index] = now;
+    _seenSet[index] = true;
+  }
+
+  _status[index]    = status;
+  _lastCheck[index] = now;
+}
@@ -0,0 +1,47 @@
+#ifndef AlicatStatusMonitor_h
+    #define AlicatStatusMonitor_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+    #include <AlicatBusBudget.h>
+
+    #define MAX_STATUS_MONITOR_DEVICES                      16
+
+    // Watches REGISTER_DEVICE_STATUS of a set of devices without spending a
+    // transaction per device and poll. Statuses that arrive with a poll (the
+    // poller folds the status into its block read) are passed to observe()
+    // and count as a check. Devices nobody polls are read at the slow
+    // background interval, and a device that had a status bit set within the
+    // hold time is read at the fast interval until it stays clear.
+    class AlicatStatusMonitor {
+        private:
+            AlicatBusBudget*    _budget;
+            int                 _budgetUser;
+            AlicatModbusRTU*    _devices[MAX_STATUS_MONITOR_DEVICES];
+            uint16_t            _status[MAX_STATUS_MONITOR_DEVICES];
+            unsigned long       _lastCheck[MAX_STATUS_MONITOR_DEVICES];
+            unsigned long       _lastSet[MAX_STATUS_MONITOR_DEVICES];        // last time a status bit was seen set
+            bool                _seenSet[MAX_STATUS_MONITOR_DEVICES];
+            uint16_t            _changed;                                   // bit i is set while device i has an unreported change
+            int                 _deviceCount;
+            int                 _nextDevice;
+            unsigned long       _slowInterval;
+            unsigned long       _fastInterval;
+            unsigned long       _holdTime;
+            unsigned long       _statusReads;
+
+            int  findDevice(AlicatModbusRTU& device);
+            void record(int index, uint16_t status, unsigned long now);
+
+        public:
+                 AlicatStatusMonitor(unsigned long slowInterval, unsigned long fastInterval);
+            bool addDevice(AlicatModbusRTU& device);
+            void setHoldTime(unsigned long holdTime);
+            bool setBusBudget(AlicatBusBudget* budget, float share = 0.0);
+            void observe(AlicatModbusRTU& device, uint16_t status);
+            bool update();
+            int  changedDevice();
+            uint16_t status(int index);
+            bool isEscalated(int index);
+            unsigned long statusReads();
+    };
+#endif
@@ -0,0 +1,365 @@
+#include <Arduino.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatTelemetry.h>
+
+
+
+/**
+ * ENCODING HELPERS
+*/
+
+static const float defaultResolution[TELEMETRY_CHANNEL_COUNT] = { 0.01, 0.01, 0.001, 0.001, 0.001 };
+
+
+
+// returns the tracked state of the device, or fresh (initialized) if the device is new and a slot is free,
+// the slot is only taken by claimDeviceState() once the record went through
+static AlicatTelemetryDeviceState* findDeviceState(AlicatTelemetryDeviceState *devices, uint8_t device, AlicatTelemetryDeviceState *fresh) {
+  bool full = true;
+
+  for (int i = 0; i < MAX_TELEMETRY_DEVICES; i++) {
+    if (devices[i].used && devices[i].device == device) return &devices[i];
+    if (!devices[i].used) full = false;
+  }
+
+  if (full) return NULL;
+
+  fresh->used      = true;
+  fresh->device    = device;
+  fresh->timestamp = 0;
+  fresh->status    = 0;
+  fresh->seen      = 0;
+
+  for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) fresh->channels[c] = 0;
+
+  return fresh;
+}
+
+
+
+static void claimDeviceState(AlicatTelemetryDeviceState *devices, const AlicatTelemetryDeviceState& fresh) {
+  for (int i = 0; i < MAX_TELEMETRY_DEVICES; i++) {
+    if (devices[i].used) continue;
+
+    devices[i] = fresh;
+
+    return;
+  }
+}
+
+
+
+static int32_t quantize(float value, float resolution) {
+  double steps = (double)value / resolution;
+
+  if (steps >  TELEMETRY_MAX_QUANTIZED) return  TELEMETRY_MAX_QUANTIZED;
+  if (steps < -TELEMETRY_MAX_QUANTIZED) return -TELEMETRY_MAX_QUANTIZED;
+
+  return (int32_t)lround(steps);
+}
+
+
+
+static int writeVarint(uint32_t value, uint8_t *data) {
+  int length = 0;
+
+  while (value >= 0x80) {
+    data[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+
+  data[length++] = (uint8_t)value;
+
+  return length;
+}
+
+
+
+static int readVarint(const uint8_t *data, int length, uint32_t *value) {
+  uint32_t result = 0;
+
+  for (int i = 0; i < length && i < 5; i++) {
+    result |= (uint32_t)(data[i] & 0x7F) << (7*i);
+
+    if (!(data[i] & 0x80)) {
+      *value = result;
+
+      return i + 1;
+    }
+  }
+
+  return 0;
+}
+
+
+
+static uint32_t zigzagEncode(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+
+
+static int32_t zigzagDecode(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+
+
+/**
+ * ENCODER
+*/
+
+/// @brief Initialize the telemetry encoder with the default channel resolutions
+AlicatTelemetryEncoder::AlicatTelemetryEncoder() {
+  for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) _resolution[c] = defaultResolution[c];
+
+  reset();
+}
+
+
+
+/// @brief Set the quantization step of a channel, the decoder must use the same value
+/// @param channel channel index (0: pressure, 1: temperature, 2: volumetric flow, 3: mass flow, 4: setpoint)
+/// @param resolution smallest change of the channel that is transmitted (> 0)
+void AlicatTelemetryEncoder::setResolution(int channel, float resolution) {
+  if (channel < 0 || channel >= TELEMETRY_CHANNEL_COUNT || resolution <= 0.0) return;
+
+  _resolution[channel] = resolution;
+}
+
+
+
+/// @brief Encode one row of a sample buffer as the delta to the previous record of the same device
+/// @param buffer sample buffer holding the snapshot
+/// @param row row of the snapshot in the buffer
+/// @param data output buffer for the encoded record
+/// @param capacity space left in the output buffer (bytes)
+/// @return number of bytes written, 0 if the record does not fit (encoder state is not changed), TELEMETRY_ERROR_DEVICE_TABLE_FULL if the device cannot be tracked
+int AlicatTelemetryEncoder::encode(AlicatSampleBuffer& buffer, int row, uint8_t *data, int capacity) {
+  return encode(buffer, row, data, capacity, 0xFF);
+}
+
+
+
+/// @brief Encode only some channels of one row (e.g. the changed channels reported by AlicatDeadband), the decoder keeps the previous value of the others
+/// @param buffer sample buffer holding the snapshot
+/// @param row row of the snapshot in the buffer
+/// @param data output buffer for the encoded record
+/// @param capacity space left in the output buffer (bytes)
+/// @param channels channels that may be sent, bit mask of (1 << SAMPLE_CHANNEL_*)
+/// @return number of bytes written, 0 if the record does not fit (encoder state is not changed), TELEMETRY_ERROR_DEVICE_TABLE_FULL if the device cannot be tracked
+int AlicatTelemetryEncoder::encode(AlicatSampleBuffer& buffer, int row, uint8_t *data, int capacity, uint8_t channels) {
+  uint8_t record[TELEMETRY_MAX_RECORD_LENGTH];
+  int32_t quantized[TELEMETRY_CHANNEL_COUNT];
+  int     length  = 2;
+  uint8_t flags   = 0;
+  uint8_t cleared = 0;
+
+  AlicatTelemetryDeviceState  fresh;
+  AlicatTelemetryDeviceState *state = findDeviceState(_devices, buffer.device[row], &fresh);
+
+  if (state == NULL) return TELEMETRY_ERROR_DEVICE_TABLE_FULL;
+
+  length += writeVarint(buffer.timestamp[row] - state->timestamp, &record[length]);
+
+  for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) {
+    float value = buffer.column(c)[row];
+
+    quantized[c] = state->channels[c];
+
+    if (!(channels & (1 << c))) continue;
+
+    if (!isfinite(value)) {
+      // a channel that was sent before and is gone now is cleared on the decoder
+      if (state->seen & (1 << c)) {
+        cleared     |= (1 << c);
+        quantized[c] = 0;
+      }
+
+      continue;
+    }
+
+    quantized[c] = quantize(value, _resolution[c]);
+
+    if (quantized[c] == state->channels[c] && (state->seen & (1 << c))) continue;
+
+    flags  |= (1 << c);
+    length += writeVarint(zigzagEncode(quantized[c] - state->channels[c]), &record[length]);
+  }
+
+  if (buffer.status[row] != state->status && (channels & (1 << SAMPLE_CHANNEL_STATUS))) {
+    flags  |= TELEMETRY_FLAG_STATUS;
+    length += writeVarint(buffer.status[row], &record[length]);
+  }
+
+  if (cleared) {
+    flags            |= TELEMETRY_FLAG_CLEARED;
+    record[length++]  = cleared;
+  }
+
+  if (length > capacity) return 0;
+
+  record[0] = buffer.device[row];
+  record[1] = flags;
+  memcpy(data, record, length);
+
+  state->timestamp = buffer.timestamp[row];
+  state->status    = flags & TELEMETRY_FLAG_STATUS ? buffer.status[row] : state->status;
+  state->seen      = (state->seen | (flags & TELEMETRY_CHANNEL_FLAGS)) & ~cleared;
+
+  for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) state->channels[c] = quantized[c];
+
+  if (state == &fresh) claimDeviceState(_devices, fresh);
+
+  _rawBytes     += TELEMETRY_RAW_RECORD_LENGTH;
+  _encodedBytes += length;
+
+  return length;
+}
+
+
+
+/// @brief Forget the per device history, the next record of every device is sent in full (the decoder must be reset as well)
+void AlicatTelemetryEncoder::reset() {
+  for (int i = 0; i < MAX_TELEMETRY_DEVICES; i++) _devices[i].used = false;
+
+  _rawBytes     = 0;
+  _encodedBytes = 0;
+}
+
+
+
+/// @brief Get the number of bytes the encoded records would have taken as plain binary
+/// @return raw byte count since the last reset
+unsigned long AlicatTelemetryEncoder::rawBytes() {
+  return _rawBytes;
+}
+
+
+
+/// @brief Get the number of bytes produced by the encoder
+/// @return encoded byte count since the last reset
+unsigned long AlicatTelemetryEncoder::encodedBytes() {
+  return _encodedBytes;
+}
+
+
+
+/// @brief Get the achieved compression ratio
+/// @return raw bytes / encoded bytes since the last reset (0 if nothing was encoded)
+float AlicatTelemetryEncoder::compressionRatio() {
+  if (_encodedBytes == 0) return 0.0;
+
+  return (float)_rawBytes / (float)_encodedBytes;
+}
+
+
+
+/**
+ * DECODER
+*/
+
+/// @brief Initialize the telemetry decoder with the default channel resolutions
+AlicatTelemetryDecoder::AlicatTelemetryDecoder() {
+  for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) _resolution[c] = defaultResolution[c];
+
+  reset();
+}
+
+
+
+/// @brief Set the quantization step of a channel, must match the encoder
+/// @param channel channel index (0: pressure, 1: temperature, 2: volumetric flow, 3: mass flow, 4: setpoint)
+/// @param resolution quantization step of the channel (> 0)
+void AlicatTelemetryDecoder::setResolution(int channel, float resolution) {
+  if (channel < 0 || channel >= TELEMETRY_CHANNEL_COUNT || resolution <= 0.0) return;
+
+  _resolution[channel] = resolution;
+}
+
+
+
+/// @brief Decode one record and append the reconstructed snapshot to a sample buffer
+/// @param data encoded stream, starting at a record boundary
+/// @param length bytes available in data
+/// @param buffer sample buffer the snapshot is appended to
+/// @return number of bytes consumed, 0 if the record is incomplete or malformed (nothing is appended), TELEMETRY_ERROR_DEVICE_TABLE_FULL if the device cannot be tracked
+int AlicatTelemetryDecoder::decode(const uint8_t *data, int length, AlicatSampleBuffer& buffer) {
+  if (length < 3) return 0;
+
+  uint8_t  device = data[0];
+  uint8_t  flags  = data[1];
+  int      offset = 2;
+  int      consumed;
+  uint32_t value;
+  int32_t  channels[TELEMETRY_CHANNEL_COUNT];
+  uint8_t  cleared = 0;
+
+  AlicatTelemetryDeviceState  fresh;
+  AlicatTelemetryDeviceState *state = findDeviceState(_devices, device, &fresh);
+
+  if (state == NULL) return TELEMETRY_ERROR_DEVICE_TABLE_FULL;
+
+  consumed = readVarint(&data[offset], length - offset, &value);
+  if (consumed == 0) return 0;
+  offset += consumed;
+
+  unsigned long timestamp = state->timestamp + value;
+  uint16_t      status    = state->status;
+
+  for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) {
+    channels[c] = state->channels[c];
+
+    if (!(flags & (1 << c))) continue;
+
+    consumed = readVarint(&data[offset], length - offset, &value);
+    if (consumed == 0) return 0;
+    offset += consumed;
+
+    channels[c] += zigzagDecode(value);
+  }
+
+  if (flags & TELEMETRY_FLAG_STATUS) {
+    consumed = readVarint(&data[offset], length - offset, &value);
+    if (consumed == 0) return 0;
+    offset += consumed;
+
+    status = (uint16_t)value;
+  }
+
+  if (flags & TELEMETRY_FLAG_CLEARED) {
+    if (offset >= length) return 0;
+
+    cleared = data[offset++] & TELEMETRY_CHANNEL_FLAGS;
+
+    for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) {
+      if (cleared & (1 << c)) channels[c] = 0;
+    }
+  }
+
+  state->timestamp = timestamp;
+  state->status    = status;
+  state->seen      = (state->seen | (flags & TELEMETRY_CHANNEL_FLAGS)) & ~cleared;
+
+  int row = buffer.append(timestamp, device);
+
+  buffer.status[row] = status;
+
+  for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) {
+    // a channel that has never been sent stays NAN
+    if (state->seen & (1 << c)) buffer.column(c)[row] = channels[c] * _resolution[c];
+
+    state->channels[c] = channels[c];
+  }
+
+  if (state == &fresh) claimDeviceState(_devices, fresh);
+
+  return offset;
+}
+
+
+
+/// @brief Forget the per device history (the encoder must be reset as well)
+void AlicatTelemetryDecoder::reset() {
+  for (int i = 0; i < MAX_TELEMETRY_DEVICES; i++) _devices[i].used = false;
+}
@@ -0,0 +1,68 @@
+#ifndef AlicatTelemetry_h
+    #define AlicatTelemetry_h
+    #include <Arduino.h>
+    #include <AlicatSampleBuffer.h>
+
+    #define MAX_TELEMETRY_DEVICES                           20
+    #define TELEMETRY_CHANNEL_COUNT                         5       // pressure, temperature, volumetric flow, mass flow, setpoint
+    #define TELEMETRY_MAX_RECORD_LENGTH                     40      // worst case encoded size of one snapshot (36 bytes)
+    #define TELEMETRY_RAW_RECORD_LENGTH                     27      // size of one snapshot as plain binary (timestamp, device, 5 floats, status)
+    #define TELEMETRY_MAX_QUANTIZED                         0x3FFFFFFF  // quantized values are clamped to +/- this, so the delta of two values fits in 32 bits
+
+    #define TELEMETRY_FLAG_STATUS                           0x80    // record carries the status word (only sent when it changes)
+    #define TELEMETRY_FLAG_CLEARED                          0x40    // record carries a byte of channels that went NAN
+    #define TELEMETRY_CHANNEL_FLAGS                         ((1 << TELEMETRY_CHANNEL_COUNT) - 1)
+
+    #define TELEMETRY_ERROR_DEVICE_TABLE_FULL               -1      // more than MAX_TELEMETRY_DEVICES devices, the record cannot be handled
+
+    // Per device state shared by the encoder and decoder, both sides have to
+    // see the same sequence of records to stay in step.
+    struct AlicatTelemetryDeviceState {
+        uint8_t             device;
+        bool                used;
+        unsigned long       timestamp;
+        int32_t             channels[TELEMETRY_CHANNEL_COUNT];
+        uint16_t            status;
+        uint8_t             seen;           // bit c is set while channel c holds a sent value
+    };
+
+    // Record layout (all integers are LEB128 varints, signed values are zigzag encoded):
+    //   device (1 byte) | flags (1 byte) | timestamp delta (ms) | channel deltas for each set flag bit 0-4 | status if TELEMETRY_FLAG_STATUS
+    //   | cleared channels (1 byte, bits 0-4) if TELEMETRY_FLAG_CLEARED
+    // Channel values are quantized to the channel resolution and sent as the
+    // delta to the previous record of the same device. Channels that did not
+    // move by at least one quantization step are left out, as are NAN and
+    // infinite channels (the decoder reports NAN until a channel is sent for
+    // the first time). A channel that stops being finite after it was sent is
+    // cleared, and the decoder reports NAN again until it comes back. Values
+    // beyond TELEMETRY_MAX_QUANTIZED quantization steps are clamped.
+    class AlicatTelemetryEncoder {
+        private:
+            AlicatTelemetryDeviceState  _devices[MAX_TELEMETRY_DEVICES];
+            float                       _resolution[TELEMETRY_CHANNEL_COUNT];
+            unsigned long               _rawBytes;
+            unsigned long               _encodedBytes;
+
+        public:
+                  AlicatTelemetryEncoder();
+            void  setResolution(int channel, float resolution);
+            int   encode(AlicatSampleBuffer& buffer, int row, uint8_t *data, int capacity);
+            int   encode(AlicatSampleBuffer& buffer, int row, uint8_t *data, int capacity, uint8_t channels);
+            void  reset();
+            unsigned long rawBytes();
+            unsigned long encodedBytes();
+            float compressionRatio();
+    };
+
+    class AlicatTelemetryDecoder {
+        private:
+            AlicatTelemetryDeviceState  _devices[MAX_TELEMETRY_DEVICES];
+            float                       _resolution[TELEMETRY_CHANNEL_COUNT];
+
+        public:
+                  AlicatTelemetryDecoder();
+            void  setResolution(int channel, float resolution);
+            int   decode(const uint8_t *data, int length, AlicatSampleBuffer& buffer);
+            void  reset();
+    };
+#endif
@@ -0,0 +1,181 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatTotalizer.h>
+
+
+
+/// @brief Initialize the AlicatTotalizer object (Mass flow devices only)
+/// @param device handle to the AlicatModbusRTU object
+AlicatTotalizer::AlicatTotalizer(AlicatModbusRTU& device)
+: _device(device)
+{
+  _flowTimeBase       = 60.0;
+  _reconcileInterval  = 60000;
+  _sampleInterval     = 100;
+  _tolerance          = 0.0;
+  _total              = 0.0;
+  _drift              = 0.0;
+  _hostSinceReconcile = 0.0;
+  _hasSample          = false;
+  _lastDeviceTotal    = NAN;
+  _lastReconcileTime  = millis();
+  _lastReadTime       = _lastReconcileTime - _sampleInterval;
+}
+
+
+
+/// @brief Set the time unit of the mass flow units
+/// @param secondsPerFlowTimeUnit 60 for per-minute units (default), 1 for per-second units, 3600 for per-hour units
+void AlicatTotalizer::setFlowTimeBase(float secondsPerFlowTimeUnit) {
+  if (secondsPerFlowTimeUnit <= 0.0) return;
+
+  _flowTimeBase = secondsPerFlowTimeUnit;
+}
+
+
+
+/// @brief Set how often update() reads the device totalizer
+/// @param reconcileInterval reconcile interval (ms), 0 to never reconcile from update()
+void AlicatTotalizer::setReconcileInterval(unsigned long reconcileInterval) {
+  _reconcileInterval = reconcileInterval;
+}
+
+
+
+/// @brief Set how often update() reads the mass flow
+/// @param sampleInterval sample interval (ms), 0 to never read the mass flow from update() (samples come from addSample())
+void AlicatTotalizer::setSampleInterval(unsigned long sampleInterval) {
+  _sampleInterval = sampleInterval;
+}
+
+
+
+/// @brief Set the drift at which the host total is corrected to the device totalizer
+/// @param tolerance accumulated drift before a correction is applied (total units, 0 corrects at every reconciliation)
+void AlicatTotalizer::setTolerance(float tolerance) {
+  _tolerance = tolerance < 0.0 ? 0.0 : tolerance;
+}
+
+
+
+/// @brief Integrate a mass flow sample taken elsewhere (e.g. by the poller)
+/// @param massFlow mass flow reading
+/// @param timestamp time the reading was taken (ms)
+void AlicatTotalizer::addSample(float massFlow, unsigned long timestamp) {
+  if (isnan(massFlow)) return;
+
+  if (_hasSample) {
+    double increment = ((double)_lastFlow + (double)massFlow) / 2.0 * (double)(timestamp - _lastSampleTime) / 1000.0 / _flowTimeBase;
+
+    _total              += increment;
+    _hostSinceReconcile += increment;
+  }
+
+  _lastFlow       = massFlow;
+  _lastSampleTime = timestamp;
+  _hasSample      = true;
+}
+
+
+
+/// @brief Read and integrate the mass flow when the sample interval has elapsed, reconcile when the reconcile interval has elapsed (call this from loop())
+/// @return true if a mass flow sample was integrated, false if none was due or the read failed
+bool AlicatTotalizer::update() {
+  bool          sampled = false;
+  unsigned long now     = millis();
+
+  if (_sampleInterval > 0 && now - _lastReadTime >= _sampleInterval) {
+    float massFlow = NAN;
+
+    _lastReadTime = now;
+    _device.getMassFlow(&massFlow);
+
+    if (!isnan(massFlow)) {
+      addSample(massFlow, now);
+      sampled = true;
+    }
+  }
+
+  if (_reconcileInterval > 0 && millis() - _lastReconcileTime >= _reconcileInterval) reconcile();
+
+  return sampled;
+}
+
+
+
+/// @brief Compare the host total with the device totalizer, status and total are read in one transaction
+/// @return true if the device totalizer was used, false if it could not be read, overflowed or was reset
+bool AlicatTotalizer::reconcile() {
+  uint16_t response[MAX_BLOCK_READ_REGISTERS];
+  int      totalAddress;
+
+  _lastReconcileTime = millis();
+
+  // the total is statistic 6 on controllers and 5 on meters (see AlicatModbusRTU::getMassTotal)
+  _device.getDeviceStatisticRegisterAddress(_device.deviceIsController() ? 6 : 5, &totalAddress);
+
+  int totalOffset = totalAddress - REGISTER_DEVICE_STATUS;
+
+  if (!_device.readRegisters(REGISTER_DEVICE_STATUS, totalOffset + 2, response)) return false;
+
+  uint16_t status      = response[0];
+  float    deviceTotal = AlicatModbusRTU::registersToFloat(&response[totalOffset]);
+
+  if (isnan(deviceTotal)) return false;
+
+  bool usable = !isnan(_lastDeviceTotal) && deviceTotal >= _lastDeviceTotal && !(status & STATUS_BIT_TOTALIZER_OVERFLOW);
+
+  if (usable) {
+    _drift += (double)(deviceTotal - _lastDeviceTotal) - _hostSinceReconcile;
+
+    if (fabs(_drift) > _tolerance) {
+      _total += _drift;
+      _drift  = 0.0;
+    }
+  }
+
+  _lastDeviceTotal    = deviceTotal;
+  _hostSinceReconcile = 0.0;
+
+  return usable;
+}
+
+
+
+/// @brief Reset the device totalizer and the host total
+/// @return true if the device totalizer was reset, false if the reset failed (the host total is kept)
+bool AlicatTotalizer::reset() {
+  if (!_device.sendSpecialCommand(SPECIAL_COMMAND_RESET_TOTALIZER_VALUE, 0)) return false;
+
+  _total     = 0.0;
+  _hasSample = false;
+
+  rebaseline();
+
+  return true;
+}
+
+
+
+/// @brief Get the host total
+/// @return integrated total (total units of the device)
+double AlicatTotalizer::total() {
+  return _total;
+}
+
+
+
+/// @brief Get the drift accumulated since the last correction
+/// @return device total minus host total since the last correction (total units)
+double AlicatTotalizer::drift() {
+  return _drift;
+}
+
+
+
+void AlicatTotalizer::rebaseline() {
+  _drift              = 0.0;
+  _hostSinceReconcile = 0.0;
+  _lastDeviceTotal    = NAN;
+  _lastReconcileTime  = millis();
+}
@@ -0,0 +1,49 @@
+#ifndef AlicatTotalizer_h
+    #define AlicatTotalizer_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    // Host-side totalizer for mass flow devices. Mass flow samples are
+    // integrated with the trapezoidal rule using their timestamps, in double
+    // precision (note: double is 32 bits on AVR boards, 64 bits on ARM/ESP32).
+    // The device totalizer is read every reconcile interval: the difference
+    // between what the device counted and what the host integrated since the
+    // previous reconciliation is accumulated as drift, and once it exceeds
+    // the tolerance the host total is corrected by it. Reconciliation is
+    // skipped while the device totalizer has overflowed or was reset, so the
+    // host total keeps counting past the device limit. update() reads the
+    // mass flow at the sample interval; with a poller already reading the
+    // device, set the interval to 0 and pass its samples to addSample().
+    class AlicatTotalizer {
+        private:
+            AlicatModbusRTU&    _device;
+            double              _total;
+            double              _drift;
+            double              _hostSinceReconcile;
+            float               _lastFlow;
+            float               _lastDeviceTotal;
+            float               _flowTimeBase;
+            float               _tolerance;
+            unsigned long       _lastSampleTime;
+            unsigned long       _lastReconcileTime;
+            unsigned long       _reconcileInterval;
+            unsigned long       _sampleInterval;
+            unsigned long       _lastReadTime;
+            bool                _hasSample;
+
+            void   rebaseline();
+
+        public:
+                   AlicatTotalizer(AlicatModbusRTU& device);
+            void   setFlowTimeBase(float secondsPerFlowTimeUnit);
+            void   setReconcileInterval(unsigned long reconcileInterval);
+            void   setSampleInterval(unsigned long sampleInterval);
+            void   setTolerance(float tolerance);
+            void   addSample(float massFlow, unsigned long timestamp);
+            bool   update();
+            bool   reconcile();
+            bool   reset();
+            double total();
+            double drift();
+    };
+#endif
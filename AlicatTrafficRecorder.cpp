@@ -0,0 +1,218 @@
+#include <Arduino.h>
+#include <AlicatTrafficRecorder.h>
+
+
+
+/// @brief Get a register value of the record
+/// @param index index of the register in the record (0 to count-1)
+/// @return register value
+uint16_t AlicatTrafficRecord::value(int index) const {
+  return (uint16_t)values[2*index] | ((uint16_t)values[2*index + 1] << 8);
+}
+
+
+
+/**
+ * RECORDER
+*/
+
+/// @brief Initialize a recorder that appends to a RAM buffer
+/// @param storage buffer receiving the records
+/// @param capacity size of the buffer (bytes)
+AlicatTrafficRecorder::AlicatTrafficRecorder(uint8_t *storage, size_t capacity) {
+  _storage    = storage;
+  _capacity   = capacity;
+  _sink       = NULL;
+
+  clear();
+}
+
+
+
+/// @brief Initialize a recorder that writes every record to a Print sink (e.g. an SD card file)
+/// @param sink destination of the records
+AlicatTrafficRecorder::AlicatTrafficRecorder(Print& sink) {
+  _storage    = NULL;
+  _capacity   = 0;
+  _sink       = &sink;
+
+  clear();
+}
+
+
+
+/// @brief Append one transaction to the recording
+/// @param device Modbus ID the transaction was addressed to
+/// @param functionCode Modbus function code (see MODBUS_FUNCTION_* constants)
+/// @param address first register address of the transaction
+/// @param values register values read or written
+/// @param count number of registers
+/// @param ok true if the transaction succeeded
+void AlicatTrafficRecorder::record(uint8_t device, uint8_t functionCode, uint16_t address, const uint16_t *values, uint8_t count, bool ok) {
+  size_t        recordLength = TRAFFIC_RECORD_HEADER_LENGTH + 2*count;
+  unsigned long timestamp    = millis();
+  uint8_t       header[TRAFFIC_RECORD_HEADER_LENGTH];
+
+  header[0] = (uint8_t)(timestamp);
+  header[1] = (uint8_t)(timestamp >> 8);
+  header[2] = (uint8_t)(timestamp >> 16);
+  header[3] = (uint8_t)(timestamp >> 24);
+  header[4] = device;
+  header[5] = functionCode;
+  header[6] = (uint8_t)(address);
+  header[7] = (uint8_t)(address >> 8);
+  header[8] = count;
+  header[9] = ok ? TRAFFIC_RECORD_FLAG_OK : 0;
+
+  if (_sink != NULL) {
+    _sink->write(header, TRAFFIC_RECORD_HEADER_LENGTH);
+
+    for (int i = 0; i < count; i++) {
+      _sink->write((uint8_t)(values[i]));
+      _sink->write((uint8_t)(values[i] >> 8));
+    }
+
+    _length += recordLength;
+
+    return;
+  }
+
+  if (_length + recordLength > _capacity) {
+    _overflowed = true;
+
+    return;
+  }
+
+  uint8_t *destination = &_storage[_length];
+
+  memcpy(destination, header, TRAFFIC_RECORD_HEADER_LENGTH);
+  destination += TRAFFIC_RECORD_HEADER_LENGTH;
+
+  for (int i = 0; i < count; i++) {
+    *destination++ = (uint8_t)(values[i]);
+    *destination++ = (uint8_t)(values[i] >> 8);
+  }
+
+  _length += recordLength;
+}
+
+
+
+/// @brief Get the recorded bytes (RAM buffer recorders only)
+/// @return pointer to the start of the recording, NULL for Print sink recorders
+const uint8_t* AlicatTrafficRecorder::data() {
+  return _storage;
+}
+
+
+
+/// @brief Get the number of bytes recorded
+/// @return recording length (bytes)
+size_t AlicatTrafficRecorder::length() {
+  return _length;
+}
+
+
+
+/// @brief Check if records were dropped because the RAM buffer was full
+/// @return true if at least one record was dropped, false otherwise
+bool AlicatTrafficRecorder::overflowed() {
+  return _overflowed;
+}
+
+
+
+/// @brief Discard the recording and start again at the beginning of the buffer
+void AlicatTrafficRecorder::clear() {
+  _length     = 0;
+  _overflowed = false;
+}
+
+
+
+/**
+ * READER
+*/
+
+/// @brief Initialize a reader over a recording
+/// @param data start of the recording
+/// @param length length of the recording (bytes)
+AlicatTrafficReader::AlicatTrafficReader(const uint8_t *data, size_t length) {
+  _data     = data;
+  _length   = length;
+  _position = 0;
+  _device   = -1;
+  _address  = -1;
+}
+
+
+
+/// @brief Only return records matching the given device and register address
+/// @param device Modbus ID to match, -1 for any device
+/// @param address register address to match (any register covered by the transaction), -1 for any address
+void AlicatTrafficReader::setFilter(int device, int address) {
+  _device  = device;
+  _address = address;
+}
+
+
+
+/// @brief Read the next record that matches the filter
+/// @param record the record read, its values point into the recording
+/// @return true if a record was read, false at the end of the recording
+bool AlicatTrafficReader::next(AlicatTrafficRecord *record) {
+  while (_position + TRAFFIC_RECORD_HEADER_LENGTH <= _length) {
+    const uint8_t *header       = &_data[_position];
+    size_t         recordLength = TRAFFIC_RECORD_HEADER_LENGTH + 2*header[8];
+
+    // a truncated record at the end of the recording is ignored
+    if (_position + recordLength > _length) return false;
+
+    _position += recordLength;
+
+    uint8_t  device  = header[4];
+    uint16_t address = (uint16_t)header[6] | ((uint16_t)header[7] << 8);
+
+    if (_device  >= 0 && device  != _device)  continue;
+    if (_address >= 0 && (_address < address || _address >= address + header[8])) continue;
+
+    record->timestamp    = (unsigned long)header[0]
+                         | ((unsigned long)header[1] << 8)
+                         | ((unsigned long)header[2] << 16)
+                         | ((unsigned long)header[3] << 24);
+    record->device       = device;
+    record->functionCode = header[5];
+    record->address      = address;
+    record->count        = header[8];
+    record->ok           = header[9] & TRAFFIC_RECORD_FLAG_OK;
+    record->values       = &header[TRAFFIC_RECORD_HEADER_LENGTH];
+
+    return true;
+  }
+
+  return false;
+}
+
+
+
+/// @brief Go back to the start of the recording
+void AlicatTrafficReader::rewind() {
+  _position = 0;
+}
+
+
+
+/// @brief Count the records that match the filter (rewinds the reader)
+/// @return number of matching records
+int AlicatTrafficReader::count() {
+  AlicatTrafficRecord record;
+  int                 matches = 0;
+
+  rewind();
+
+  while (next(&record)) matches++;
+
+  rewind();
+
+  return matches;
+}
@@ -0,0 +1,66 @@
+#ifndef AlicatTrafficRecorder_h
+    #define AlicatTrafficRecorder_h
+    #include <Arduino.h>
+
+    #define MODBUS_FUNCTION_READ_HOLDING_REGISTERS          3
+    #define MODBUS_FUNCTION_WRITE_MULTIPLE_REGISTERS        16
+
+    #define TRAFFIC_RECORD_HEADER_LENGTH                    10      // timestamp (4), device (1), function (1), address (2), count (1), flags (1)
+    #define TRAFFIC_RECORD_FLAG_OK                          0x01    // transaction succeeded
+
+    // One recorded transaction. For reads the values are the response, for
+    // writes they are the values that were sent. All addresses are the
+    // register addresses before setRegisterOffset is applied.
+    struct AlicatTrafficRecord {
+        unsigned long       timestamp;      // millis() at the end of the transaction
+        uint8_t             device;
+        uint8_t             functionCode;
+        uint16_t            address;
+        uint8_t             count;
+        bool                ok;
+        const uint8_t*      values;         // count registers, little-endian, not aligned
+
+        uint16_t            value(int index) const;
+    };
+
+    // Append-only recorder of every transaction an AlicatModbusRTU object
+    // performs. Records go either into a caller supplied RAM buffer (a memcpy
+    // per transaction, recording stops when the buffer is full) or straight
+    // to a Print sink such as an SD card file.
+    class AlicatTrafficRecorder {
+        private:
+            uint8_t*            _storage;
+            size_t              _capacity;
+            size_t              _length;
+            Print*              _sink;
+            bool                _overflowed;
+
+        public:
+                   AlicatTrafficRecorder(uint8_t *storage, size_t capacity);
+                   AlicatTrafficRecorder(Print& sink);
+            void   record(uint8_t device, uint8_t functionCode, uint16_t address, const uint16_t *values, uint8_t count, bool ok);
+            const uint8_t* data();
+            size_t length();
+            bool   overflowed();
+            void   clear();
+    };
+
+    // Walks a recording made by AlicatTrafficRecorder, optionally only
+    // returning the records of one device and / or the transactions that
+    // cover one register address (e.g. a block read including it).
+    class AlicatTrafficReader {
+        private:
+            const uint8_t*      _data;
+            size_t              _length;
+            size_t              _position;
+            int                 _device;
+            int                 _address;
+
+        public:
+                 AlicatTrafficReader(const uint8_t *data, size_t length);
+            void setFilter(int device, int address);
+            bool next(AlicatTrafficRecord *record);
+            void rewind();
+            int  count();
+    };
+#endif
@@ -0,0 +1,136 @@
+#include <Arduino.h>
+#include <AlicatTrafficRecorder.h>
+#include <AlicatTrafficReplay.h>
+
+
+
+/// @brief Initialize a replay over a recording
+/// @param data start of the recording
+/// @param length length of the recording (bytes)
+AlicatTrafficReplay::AlicatTrafficReplay(const uint8_t *data, size_t length)
+: _reader(data, length)
+{
+  _speed = 1.0;
+
+  rewind();
+}
+
+
+
+/// @brief Set the replay speed
+/// @param speed 1.0 for the original timing, 10.0 for ten times faster, 0 for no pacing
+void AlicatTrafficReplay::setSpeed(float speed) {
+  _speed = speed < 0.0 ? 0.0 : speed;
+}
+
+
+
+/// @brief Restart the replay at the beginning of the recording
+void AlicatTrafficReplay::rewind() {
+  _reader.rewind();
+
+  _started    = false;
+  _mismatches = 0;
+}
+
+
+
+/// @brief Answer a read from the recording
+/// @param device Modbus ID the read is addressed to
+/// @param address first register address
+/// @param count number of registers
+/// @param values receives the recorded response
+/// @return the recorded success flag, false if no matching record is left
+bool AlicatTrafficReplay::readRegisters(uint8_t device, uint16_t address, uint8_t count, uint16_t *values) {
+  AlicatTrafficRecord record;
+
+  if (!findRecord(device, MODBUS_FUNCTION_READ_HOLDING_REGISTERS, address, count, &record)) return false;
+
+  waitFor(record);
+
+  if (!record.ok) return false;
+
+  for (int i = 0; i < count; i++) values[i] = record.value(i);
+
+  return true;
+}
+
+
+
+/// @brief Consume a write from the recording (nothing is sent to the bus)
+/// @param device Modbus ID the write is addressed to
+/// @param address first register address
+/// @param values values being written, counted as a mismatch if they differ from the recording
+/// @param count number of registers
+/// @return the recorded success flag, false if no matching record is left
+bool AlicatTrafficReplay::writeRegisters(uint8_t device, uint16_t address, const uint16_t *values, uint8_t count) {
+  AlicatTrafficRecord record;
+
+  if (!findRecord(device, MODBUS_FUNCTION_WRITE_MULTIPLE_REGISTERS, address, count, &record)) return false;
+
+  for (int i = 0; i < count; i++) {
+    if (record.value(i) != values[i]) {
+      _mismatches++;
+
+      break;
+    }
+  }
+
+  waitFor(record);
+
+  return record.ok;
+}
+
+
+
+/// @brief Get the number of requests that did not match the recording
+/// @return requests without a matching record, plus writes whose values differed from the recording
+unsigned long AlicatTrafficReplay::mismatches() {
+  return _mismatches;
+}
+
+
+
+/// @brief Find the next record matching a request, records skipped on the way are not replayed
+/// @return true if a record was found, false otherwise (the position in the recording is unchanged)
+bool AlicatTrafficReplay::findRecord(uint8_t device, uint8_t functionCode, uint16_t address, uint8_t count, AlicatTrafficRecord *record) {
+  AlicatTrafficReader search = _reader;
+
+  while (search.next(record)) {
+    if (record->device == device && record->functionCode == functionCode && record->address == address && record->count == count) {
+      _reader = search;
+
+      return true;
+    }
+
+    // failed reads are recorded without values
+    if (!record->ok && record->device == device && record->functionCode == functionCode && record->address == address) {
+      _reader = search;
+
+      return true;
+    }
+  }
+
+  _mismatches++;
+
+  return false;
+}
+
+
+
+/// @brief Hold the reply back until the recorded time of the record, scaled by the replay speed
+void AlicatTrafficReplay::waitFor(const AlicatTrafficRecord& record) {
+  if (!_started) {
+    _started        = true;
+    _startTime      = millis();
+    _firstTimestamp = record.timestamp;
+
+    return;
+  }
+
+  if (_speed == 0.0) return;
+
+  unsigned long offset = (unsigned long)((record.timestamp - _firstTimestamp) / _speed);
+
+  while (millis() - _startTime < offset) yield();
+}
@@ -0,0 +1,33 @@
+#ifndef AlicatTrafficReplay_h
+    #define AlicatTrafficReplay_h
+    #include <Arduino.h>
+    #include <AlicatTrafficRecorder.h>
+
+    // Answers AlicatModbusRTU transactions from a recording made by
+    // AlicatTrafficRecorder instead of the bus (see setTrafficReplay). Each
+    // request is matched against the next record in the capture with the
+    // same device, function code, address and register count, so a sketch
+    // issuing the same sequence of calls gets exactly the recorded answers.
+    // Replies are paced to the recorded timestamps divided by the speed
+    // factor, a speed of 0 replays as fast as possible.
+    class AlicatTrafficReplay {
+        private:
+            AlicatTrafficReader _reader;
+            float               _speed;
+            bool                _started;
+            unsigned long       _startTime;
+            unsigned long       _firstTimestamp;
+            unsigned long       _mismatches;
+
+            bool  findRecord(uint8_t device, uint8_t functionCode, uint16_t address, uint8_t count, AlicatTrafficRecord *record);
+            void  waitFor(const AlicatTrafficRecord& record);
+
+        public:
+                  AlicatTrafficReplay(const uint8_t *data, size_t length);
+            void  setSpeed(float speed);
+            void  rewind();
+            bool  readRegisters(uint8_t device, uint16_t address, uint8_t count, uint16_t *values);
+            bool  writeRegisters(uint8_t device, uint16_t address, const uint16_t *values, uint8_t count);
+            unsigned long mismatches();
+    };
+#endif
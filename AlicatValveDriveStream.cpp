@@ -0,0 +1,85 @@
+#include <Arduino.h>
+#include <AlicatModbusRTU.h>
+#include <AlicatValveDriveStream.h>
+
+
+
+/// @brief Initialize the AlicatValveDriveStream object (Controller devices only)
+/// @param device handle to the AlicatModbusRTU object
+AlicatValveDriveStream::AlicatValveDriveStream(AlicatModbusRTU& device)
+: _device(device)
+{
+  _readbackEvery = 0;
+  _lastReadback  = NAN;
+
+  begin();
+}
+
+
+
+/// @brief Read the valve drive back after every N writes
+/// @param readbackEvery read back interval in writes, 0 to never read back (default)
+void AlicatValveDriveStream::setReadbackEvery(unsigned long readbackEvery) {
+  _readbackEvery = readbackEvery;
+}
+
+
+
+/// @brief Start a new measurement of the achieved update rate
+void AlicatValveDriveStream::begin() {
+  _firstWriteTime = 0;
+  _lastWriteTime  = 0;
+  _writeCount     = 0;
+}
+
+
+
+/// @brief Send one valve drive value
+/// @param valveDrive valve drive (0.0-100.0 %, not range checked to keep the write path short)
+/// @return true if the value was written, false if the device is not a controller or the write failed
+bool AlicatValveDriveStream::write(float valveDrive) {
+  uint16_t frame[2];
+
+  if (!_device.deviceIsController()) return false;
+
+  AlicatModbusRTU::floatToRegisters(valveDrive, frame);
+
+  if (!_device.writeRegisters(REGISTER_DIRECT_VALVE_DRIVE, frame, 2)) return false;
+
+  // the rate is timed from the first write, idle time after begin() does not count
+  _lastWriteTime = millis();
+  if (_writeCount == 0) _firstWriteTime = _lastWriteTime;
+  _writeCount++;
+
+  if (_readbackEvery > 0 && _writeCount % _readbackEvery == 0) _device.getValveDrive(&_lastReadback);
+
+  return true;
+}
+
+
+
+/// @brief Get the valve drive read back most recently
+/// @return valve drive (%), NAN if nothing has been read back
+float AlicatValveDriveStream::lastReadback() {
+  return _lastReadback;
+}
+
+
+
+/// @brief Get the achieved update rate since begin()
+/// @return writes per second between the first and the last successful write, 0 until two writes are at least 1 ms apart
+float AlicatValveDriveStream::achievedRate() {
+  unsigned long elapsed = _lastWriteTime - _firstWriteTime;
+
+  if (_writeCount < 2 || elapsed == 0) return 0.0;
+
+  return (_writeCount - 1) * 1000.0 / elapsed;
+}
+
+
+
+/// @brief Get the number of values written since begin()
+/// @return write count
+unsigned long AlicatValveDriveStream::writeCount() {
+  return _writeCount;
+}
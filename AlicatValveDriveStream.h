@@ -0,0 +1,29 @@
+#ifndef AlicatValveDriveStream_h
+    #define AlicatValveDriveStream_h
+    #include <Arduino.h>
+    #include <AlicatModbusRTU.h>
+
+    // Streams valve drive values to one controller as fast as the bus allows.
+    // Every value is a single FC16 frame to REGISTER_DIRECT_VALVE_DRIVE with
+    // no read back, unless a read back every N writes is requested. The
+    // achieved update rate is measured from the first to the last write of
+    // the stream.
+    class AlicatValveDriveStream {
+        private:
+            AlicatModbusRTU&    _device;
+            unsigned long       _firstWriteTime;
+            unsigned long       _lastWriteTime;
+            unsigned long       _writeCount;
+            unsigned long       _readbackEvery;
+            float               _lastReadback;
+
+        public:
+                  AlicatValveDriveStream(AlicatModbusRTU& device);
+            void  setReadbackEvery(unsigned long readbackEvery);
+            void  begin();
+            bool  write(float valveDrive);
+            float lastReadback();
+            float achievedRate();
+            unsigned long writeCount();
+    };
+#endif
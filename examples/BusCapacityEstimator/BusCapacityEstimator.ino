@@ -0,0 +1,30 @@
+// Estimates the load of a planned Alicat bus before any device is connected.
+// Edit the baud rate, turnaround and device list, upload, and open the serial
+// monitor at 115200 baud.
+#include <AlicatModbusRTU.h>
+#include <AlicatBusModel.h>
+#include <AlicatCapacityEstimator.h>
+
+#define FLOW_CHANNELS     ((1 << SAMPLE_CHANNEL_MASS_FLOW) | (1 << SAMPLE_CHANNEL_SETPOINT) | (1 << SAMPLE_CHANNEL_STATUS))
+#define PRESSURE_CHANNELS ((1 << SAMPLE_CHANNEL_PRESSURE) | (1 << SAMPLE_CHANNEL_SETPOINT) | (1 << SAMPLE_CHANNEL_STATUS))
+
+AlicatBusModel          model(19200);
+AlicatCapacityEstimator estimator(model);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  // measured time from the end of a request to the start of the response (us)
+  model.setTurnaround(2000);
+
+  estimator.addDevice(DEVICE_TYPE_MASS_FLOW_CONTROLLER, FLOW_CHANNELS, 10.0);
+  estimator.addDevice(DEVICE_TYPE_MASS_FLOW_CONTROLLER, FLOW_CHANNELS, 10.0);
+  estimator.addDevice(DEVICE_TYPE_MASS_FLOW_METER, (1 << SAMPLE_CHANNEL_MASS_FLOW) | (1 << SAMPLE_CHANNEL_TEMPERATURE), 2.0);
+  estimator.addDevice(DEVICE_TYPE_GAUGE_PRESSURE_CONTROLLER, PRESSURE_CHANNELS, 5.0);
+
+  estimator.print(Serial);
+}
+
+void loop() {
+}
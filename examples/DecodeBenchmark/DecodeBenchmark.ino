@@ -0,0 +1,80 @@
+// Times the float decoding paths on the target board, no device needed.
+// Compares the original union decode (one float per readRegistersAsFloat
+// call) with the block decoders registersToFloats and registersToColumns.
+// Open the serial monitor at 115200 baud.
+#include <AlicatModbusRTU.h>
+
+#define STATISTIC_COUNT   5
+#define ROWS              32
+#define ITERATIONS        1000
+
+uint16_t registers[2*STATISTIC_COUNT];
+float    values[STATISTIC_COUNT];
+float    columnStorage[STATISTIC_COUNT][ROWS];
+float*   columns[STATISTIC_COUNT];
+volatile float sink;
+
+// the decode readRegistersAsFloat used before the block API
+float unionDecode(const uint16_t *response) {
+  union {
+    float asFloat;
+    uint16_t asBytes[2];
+  } floatValueUnion;
+
+  floatValueUnion.asBytes[1] = response[0];
+  floatValueUnion.asBytes[0] = response[1];
+
+  return floatValueUnion.asFloat;
+}
+
+void report(const char *name, unsigned long elapsed) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print((float)elapsed / ITERATIONS, 2);
+  Serial.print(" us per block of ");
+  Serial.print(STATISTIC_COUNT);
+  Serial.println(" floats");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  for (int i = 0; i < STATISTIC_COUNT; i++) {
+    AlicatModbusRTU::floatToRegisters(1.5 * i + 0.25, &registers[2*i]);
+    columns[i] = columnStorage[i];
+  }
+
+  unsigned long start = micros();
+
+  for (int n = 0; n < ITERATIONS; n++) {
+    for (int i = 0; i < STATISTIC_COUNT; i++) values[i] = unionDecode(&registers[2*i]);
+
+    sink = values[n % STATISTIC_COUNT];
+  }
+
+  report("union decode", micros() - start);
+
+  start = micros();
+
+  for (int n = 0; n < ITERATIONS; n++) {
+    AlicatModbusRTU::registersToFloats(registers, STATISTIC_COUNT, values);
+
+    sink = values[n % STATISTIC_COUNT];
+  }
+
+  report("registersToFloats", micros() - start);
+
+  start = micros();
+
+  for (int n = 0; n < ITERATIONS; n++) {
+    AlicatModbusRTU::registersToColumns(registers, STATISTIC_COUNT, columns, n % ROWS);
+
+    sink = columnStorage[n % STATISTIC_COUNT][n % ROWS];
+  }
+
+  report("registersToColumns", micros() - start);
+}
+
+void loop() {
+}
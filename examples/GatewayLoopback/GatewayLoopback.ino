@@ -0,0 +1,122 @@
+// Exercises AlicatModbusTCPGateway without a network: requests are written
+// into an in-memory Stream standing in for a TCP client, and the responses
+// are printed. Covers a read answered from the snapshot, register 1202 (not
+// in the snapshot, so forwarded), a request with a bad protocol ID, a request
+// cut short and a valid request right behind it. With no Alicat on the bus
+// forwarded reads come back as exception 0x0B. Open the serial monitor at
+// 115200 baud.
+#include <AlicatModbusRTU.h>
+#include <AlicatSampleBuffer.h>
+#include <AlicatSnapshotSlot.h>
+#include <AlicatModbusTCPGateway.h>
+
+#define LOOPBACK_SIZE     64
+#define UNIT_ID           1
+
+// one TCP connection: the test writes requests with send(), the gateway reads
+// them and writes its responses, which printResponse() takes back out
+class LoopbackClient : public Stream {
+  public:
+    uint8_t request[LOOPBACK_SIZE];
+    int     requestLength = 0;
+    int     requestRead   = 0;
+    uint8_t response[LOOPBACK_SIZE];
+    int     responseLength = 0;
+
+    void send(const uint8_t *data, int length) {
+      memcpy(&request[requestLength], data, length);
+      requestLength += length;
+    }
+
+    int available() { return requestLength - requestRead; }
+    int read()      { return requestRead < requestLength ? request[requestRead++] : -1; }
+    int peek()      { return requestRead < requestLength ? request[requestRead] : -1; }
+
+    size_t write(uint8_t value) {
+      if (responseLength >= LOOPBACK_SIZE) return 0;
+
+      response[responseLength++] = value;
+
+      return 1;
+    }
+
+    void reset() {
+      requestLength  = 0;
+      requestRead    = 0;
+      responseLength = 0;
+    }
+};
+
+ModbusInterface        modbus;
+AlicatModbusRTU        alicat(UNIT_ID, DEVICE_TYPE_MASS_FLOW_CONTROLLER, modbus, Serial, false);
+AlicatSnapshotSlot     slot;
+AlicatModbusTCPGateway gateway;
+LoopbackClient         client;
+
+// FC03 request with MBAP header, wire addresses (register - 1)
+const uint8_t readStatus[]    = { 0x00, 0x01, 0x00, 0x00, 0x00, 0x06, UNIT_ID, 0x03, 0x04, 0xB0, 0x00, 0x01 };
+const uint8_t readMassFlow[]  = { 0x00, 0x02, 0x00, 0x00, 0x00, 0x06, UNIT_ID, 0x03, 0x04, 0xB8, 0x00, 0x02 };
+const uint8_t readRegister[]  = { 0x00, 0x03, 0x00, 0x00, 0x00, 0x06, UNIT_ID, 0x03, 0x04, 0xB1, 0x00, 0x01 };
+const uint8_t badProtocol[]   = { 0x00, 0x04, 0x12, 0x34, 0x00, 0x06, UNIT_ID, 0x03, 0x04, 0xB0, 0x00, 0x01 };
+const uint8_t cutShort[]      = { 0x00, 0x05, 0x00, 0x00, 0x00, 0x06, UNIT_ID, 0x03, 0x04 };
+
+void printResponse(const char *name) {
+  Serial.print(name);
+  Serial.print(":");
+
+  if (client.responseLength == 0) Serial.print(" no response");
+
+  for (int i = 0; i < client.responseLength; i++) {
+    Serial.print(" ");
+    if (client.response[i] < 0x10) Serial.print("0");
+    Serial.print(client.response[i], HEX);
+  }
+
+  Serial.println();
+  client.responseLength = 0;
+}
+
+void exchange(const char *name, const uint8_t *request, int length) {
+  client.reset();
+  client.send(request, length);
+
+  while (gateway.handle(client));
+
+  printResponse(name);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  AlicatSnapshot snapshot;
+
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.timestamp = millis();
+  snapshot.device    = UNIT_ID;
+  snapshot.massFlow  = 12.5;
+  snapshot.status    = 0x0004;
+  slot.publish(snapshot);
+
+  gateway.setTimeout(10);
+  gateway.addDevice(UNIT_ID, alicat, &slot);
+
+  exchange("status from snapshot", readStatus, sizeof(readStatus));
+  exchange("mass flow from snapshot", readMassFlow, sizeof(readMassFlow));
+  exchange("register 1202, forwarded", readRegister, sizeof(readRegister));
+  exchange("bad protocol ID, dropped", badProtocol, sizeof(badProtocol));
+
+  // times out waiting for the rest of the request and is rejected
+  exchange("cut short", cutShort, sizeof(cutShort));
+
+  // the stream is in step again for the next request
+  exchange("status after resync", readStatus, sizeof(readStatus));
+
+  Serial.print("cache hits: ");
+  Serial.print(gateway.cacheHits());
+  Serial.print(", forwarded reads: ");
+  Serial.println(gateway.forwardedReads());
+}
+
+void loop() {
+}
@@ -0,0 +1,112 @@
+// Measures AlicatSnapshotSlot on the target board, no device needed.
+// Times publish() and read(), then runs a writer against a reader and
+// counts the reads that succeeded, gave up or came back torn (a torn read
+// is a bug). On an ESP32 the writer publishes back to back in a task on the
+// other core, the worst case for the reader; on single core boards the
+// writer and the reader take turns in loop(). Open the serial monitor at
+// 115200 baud.
+#include <AlicatSampleBuffer.h>
+#include <AlicatSnapshotSlot.h>
+
+#define ITERATIONS        10000
+#define REPORT_INTERVAL   1000
+
+AlicatSnapshotSlot slot;
+volatile unsigned long published = 0;
+
+unsigned long readsOk;
+unsigned long readsFailed;
+unsigned long readsTorn;
+unsigned long lastReport;
+
+// every field carries the same count, a reading mixing two publications is torn
+void publishCount(unsigned long count) {
+  AlicatSnapshot snapshot;
+
+  snapshot.timestamp      = count;
+  snapshot.device         = 1;
+  snapshot.bus            = 0;
+  snapshot.pressure       = count;
+  snapshot.temperature    = count;
+  snapshot.volumetricFlow = count;
+  snapshot.massFlow       = count;
+  snapshot.setpoint       = count;
+  snapshot.status         = (uint16_t)count;
+
+  slot.publish(snapshot);
+}
+
+void readOnce() {
+  AlicatSnapshot snapshot;
+
+  if (!slot.read(&snapshot)) {
+    readsFailed++;
+  } else if (snapshot.pressure != snapshot.massFlow || snapshot.setpoint != (float)snapshot.timestamp) {
+    readsTorn++;
+  } else {
+    readsOk++;
+  }
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void writerTask(void *parameter) {
+  for (;;) {
+    publishCount(published);
+    published = published + 1;
+  }
+}
+#endif
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  unsigned long start = micros();
+
+  for (unsigned long n = 0; n < ITERATIONS; n++) publishCount(n);
+
+  Serial.print("publish: ");
+  Serial.print((float)(micros() - start) / ITERATIONS, 2);
+  Serial.println(" us");
+
+  start = micros();
+
+  for (unsigned long n = 0; n < ITERATIONS; n++) readOnce();
+
+  Serial.print("read: ");
+  Serial.print((float)(micros() - start) / ITERATIONS, 2);
+  Serial.println(" us");
+
+  readsOk     = 0;
+  readsFailed = 0;
+  readsTorn   = 0;
+  lastReport  = millis();
+
+#if defined(ARDUINO_ARCH_ESP32)
+  xTaskCreatePinnedToCore(writerTask, "writer", 2048, NULL, 1, NULL, 0);
+#endif
+}
+
+void loop() {
+#if !defined(ARDUINO_ARCH_ESP32)
+  publishCount(published);
+  published = published + 1;
+#endif
+
+  readOnce();
+
+  if (millis() - lastReport < REPORT_INTERVAL) return;
+
+  lastReport = millis();
+
+  Serial.print("publishes: ");
+  Serial.print(published);
+  Serial.print(", reads ok: ");
+  Serial.print(readsOk);
+  Serial.print(", gave up: ");
+  Serial.print(readsFailed);
+  Serial.print(", torn: ");
+  Serial.print(readsTorn);
+  Serial.print(", retries: ");
+  Serial.println(slot.readRetries());
+}
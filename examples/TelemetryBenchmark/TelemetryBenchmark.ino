@@ -0,0 +1,96 @@
+// Generates a synthetic poll trace, runs it through the telemetry encoder and
+// decoder, and reports the compression ratio, the encode cost and the largest
+// round trip error. No device is needed; the trace is deterministic so runs
+// on different boards can be compared. Open the serial monitor at 115200 baud.
+//
+// Trace: DEVICES mass flow controllers polled every POLL_INTERVAL ms with
+// noisy readings, a setpoint step every STEP_EVERY records, and the mass
+// flow channel missing (NAN) for a few records to exercise channel clearing.
+#include <AlicatSampleBuffer.h>
+#include <AlicatTelemetry.h>
+
+#define DEVICES           4
+#define RECORDS           2000
+#define POLL_INTERVAL     50
+#define STEP_EVERY        400
+
+AlicatSampleBuffer     trace;
+AlicatSampleBuffer     decoded;
+AlicatTelemetryEncoder encoder;
+AlicatTelemetryDecoder decoder;
+uint8_t                record[TELEMETRY_MAX_RECORD_LENGTH];
+uint32_t               seed = 12345;
+
+// small deterministic generator, the same trace on every board
+float noise(float amplitude) {
+  seed = seed * 1103515245UL + 12345UL;
+
+  return amplitude * (((seed >> 16) & 0x7FFF) / 16383.5 - 1.0);
+}
+
+void generate(int n) {
+  int   device   = n % DEVICES;
+  float setpoint = 10.0 * (1 + device) + 5.0 * ((n / STEP_EVERY) % 2);
+  int   row      = trace.append((unsigned long)n / DEVICES * POLL_INTERVAL, device + 1);
+
+  trace.pressure[row]       = 14.7 + noise(0.02);
+  trace.temperature[row]    = 22.5 + noise(0.05);
+  trace.volumetricFlow[row] = setpoint * 1.02 + noise(0.01);
+  trace.massFlow[row]       = (n > 1000 && n < 1040) ? NAN : setpoint + noise(0.005);
+  trace.setpoint[row]       = setpoint;
+  trace.status[row]         = (n > 1500 && n < 1520) ? 0x0002 : 0;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  unsigned long encodeTime = 0;
+  float         maxError   = 0.0;
+  int           stale      = 0;
+
+  for (int n = 0; n < RECORDS; n++) {
+    generate(n);
+
+    int           row   = trace.newestRow();
+    unsigned long start = micros();
+    int           length = encoder.encode(trace, row, record, sizeof(record));
+
+    encodeTime += micros() - start;
+
+    if (length <= 0 || decoder.decode(record, length, decoded) != length) {
+      Serial.println("ERROR: record could not be encoded or decoded");
+
+      return;
+    }
+
+    int out = decoded.newestRow();
+
+    for (int c = 0; c < TELEMETRY_CHANNEL_COUNT; c++) {
+      float original = trace.column(c)[row];
+      float copy     = decoded.column(c)[out];
+
+      if (isnan(original) != isnan(copy)) stale++;
+      else if (!isnan(original) && fabs(original - copy) > maxError) maxError = fabs(original - copy);
+    }
+  }
+
+  Serial.print("records: ");
+  Serial.println(RECORDS);
+  Serial.print("raw bytes: ");
+  Serial.println(encoder.rawBytes());
+  Serial.print("encoded bytes: ");
+  Serial.println(encoder.encodedBytes());
+  Serial.print("compression ratio: ");
+  Serial.println(encoder.compressionRatio(), 2);
+  Serial.print("encode time: ");
+  Serial.print((float)encodeTime / RECORDS, 2);
+  Serial.println(" us per record");
+  Serial.print("largest round trip error: ");
+  Serial.println(maxError, 4);
+  Serial.print("channels with a wrong NAN state: ");
+  Serial.println(stale);
+}
+
+void loop() {
+}